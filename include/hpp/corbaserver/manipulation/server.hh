@@ -35,6 +35,11 @@ namespace hpp {
       class Graph;
       class Problem;
       class Robot;
+      class ThreadPool;
+      class RoadmapIndex;
+      class ProjectionProfiler;
+      class ProblemLocks;
+      class JobQueue;
     }
     class HPP_MANIPULATION_CORBA_DLLAPI Server
     {
@@ -56,16 +61,49 @@ namespace hpp {
 			    const std::string& contextKind,
 			    const std::string& objectId);
 
+      /// Get the problem solver locked by the current request, or the one
+      /// the current thread is bound to, or else the selected one.
       ProblemSolverPtr_t problemSolver () throw (std::logic_error);
 
       corbaServer::ProblemSolverMapPtr_t problemSolverMap ();
 
+      /// Servant of the constraint graph interface.
+      impl::Graph& graph ();
+
+      /// Servant of the problem interface.
+      impl::Problem& problem ();
+
+      /// Servant of the robot interface.
+      impl::Robot& robot ();
+
+      /// Workers used by the servants to process batch requests.
+      impl::ThreadPool& threadPool ();
+
+      /// Index of the nodes of the roadmaps of the problems.
+      impl::RoadmapIndex& roadmapIndex ();
+
+      /// Statistics of the projections done by the servants.
+      impl::ProjectionProfiler& projectionProfiler ();
+
+      /// Reader/writer locks of the problem solvers, taken by the servants
+      /// at the beginning of each request.
+      impl::ProblemLocks& problemLocks ();
+
+      /// Executor of the jobs submitted to the problem interface.
+      impl::JobQueue& jobQueue ();
+
     private:
       corba::Server <impl::Graph>* graphImpl_;
       corba::Server <impl::Problem>* problemImpl_;
       corba::Server <impl::Robot>* robotImpl_;
 
       corbaServer::ProblemSolverMapPtr_t problemSolverMap_;
+
+      impl::ThreadPool* threadPool_;
+      impl::RoadmapIndex* roadmapIndex_;
+      impl::ProjectionProfiler* projectionProfiler_;
+      impl::ProblemLocks* problemLocks_;
+      impl::JobQueue* jobQueue_;
     }; // class Server
   } // namespace manipulation
 } // namespace hpp
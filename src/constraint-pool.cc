@@ -0,0 +1,87 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "constraint-pool.hh"
+
+#include <stdexcept>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/numerical-constraint.hh>
+#include <hpp/manipulation/problem-solver.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      namespace {
+        NumericalConstraintPtr_t copy (const NumericalConstraintPtr_t& nc)
+        {
+          return HPP_STATIC_PTR_CAST (NumericalConstraint, nc->copy ());
+        }
+      }
+
+      NumericalConstraintPtr_t ConstraintPool::get (
+          const graph::GraphPtr_t& graph, const ProblemSolverPtr_t& ps,
+          const std::string& name)
+      {
+        NumericalConstraintPtr_t source (ps->numericalConstraint (name));
+        if (!source)
+          throw std::invalid_argument ("The numerical function " + name +
+              " does not exist.");
+
+        boost::mutex::scoped_lock lock (mutex_);
+        Pool& pool (pools_.get (graph));
+        if (pool.ps != ps) {
+          // The constraints of another problem solver are not shared.
+          pool = Pool ();
+          pool.ps = ps;
+        }
+        if (!source->constantRightHandSide ()) {
+          ++pool.copies;
+          return copy (source);
+        }
+        Entry& entry = pool.entries[name];
+        if (entry.source == source) {
+          ++pool.hits;
+        } else {
+          // New constraint or constraint redefined in the problem solver.
+          entry.source = source;
+          entry.shared = copy (source);
+        }
+        return entry.shared;
+      }
+
+      std::size_t ConstraintPool::size (const graph::GraphPtr_t& graph)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return pools_.get (graph).entries.size ();
+      }
+
+      std::size_t ConstraintPool::hits (const graph::GraphPtr_t& graph)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return pools_.get (graph).hits;
+      }
+
+      std::size_t ConstraintPool::copies (const graph::GraphPtr_t& graph)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return pools_.get (graph).copies;
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
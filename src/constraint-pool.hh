@@ -0,0 +1,79 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_CONSTRAINT_POOL_HH
+# define HPP_MANIPULATION_CORBA_CONSTRAINT_POOL_HH
+
+# include <map>
+# include <string>
+
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/graph/fwd.hh>
+
+# include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Numerical constraints shared by the graph components.
+      ///
+      /// A constraint with a constant right hand side is copied once from
+      /// the problem solver and the copy is given to all the components of a
+      /// graph that use it. Other constraints are copied for each component,
+      /// since each of them sets its own right hand side.
+      ///
+      /// The shared constraints are kept per graph and per problem solver.
+      /// Those of a graph are dropped when the graph is deleted, for
+      /// instance when it is replaced by a new one.
+      class ConstraintPool
+      {
+        public:
+          /// Get the constraint to insert in a component of graph.
+          /// \param name name of the constraint in the problem solver.
+          /// \throw std::invalid_argument if there is no such constraint.
+          NumericalConstraintPtr_t get (const graph::GraphPtr_t& graph,
+              const ProblemSolverPtr_t& ps, const std::string& name);
+
+          /// Number of constraints shared by the components of graph.
+          std::size_t size (const graph::GraphPtr_t& graph);
+          /// Number of times a shared constraint of graph was reused.
+          std::size_t hits (const graph::GraphPtr_t& graph);
+          /// Number of constraints copied for a single component of graph.
+          std::size_t copies (const graph::GraphPtr_t& graph);
+
+        private:
+          struct Entry {
+            NumericalConstraintPtr_t source, shared;
+          };
+          typedef std::map <std::string, Entry> Entries_t;
+          struct Pool {
+            Pool () : ps (), hits (0), copies (0) {}
+            ProblemSolverPtr_t ps;
+            Entries_t entries;
+            std::size_t hits, copies;
+          };
+
+          WeakPtrMap <graph::Graph, Pool> pools_;
+          boost::mutex mutex_;
+      }; // class ConstraintPool
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_CONSTRAINT_POOL_HH
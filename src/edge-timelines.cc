@@ -0,0 +1,95 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "edge-timelines.hh"
+
+#include <algorithm>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/path-vector.hh>
+#include <hpp/manipulation/constraint-set.hh>
+#include <hpp/manipulation/graph/edge.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      std::size_t EdgeTimelines::Timeline::rank
+      (const core::value_type& param) const
+      {
+        if (edges.empty ()) return 0;
+        // A parameter at the boundary of two sub-paths belongs to the first
+        // one.
+        std::vector <core::value_type>::const_iterator it = std::lower_bound
+          (bounds.begin () + 1, bounds.end () - 1, param);
+        return (std::size_t) (it - bounds.begin () - 1);
+      }
+
+      EdgeTimelines::TimelinePtr_t EdgeTimelines::get
+      (const core::PathVectorPtr_t& path)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        Entries_t::iterator it = entries_.find (path.get ());
+        if (it != entries_.end ()
+            && it->second.path.lock () == path
+            && it->second.numberPaths == path->numberPaths ()
+            && it->second.length == path->length ())
+          return it->second.timeline;
+
+        // Forget the paths that were erased.
+        Entries_t::iterator e = entries_.begin ();
+        while (e != entries_.end ()) {
+          if (e->second.path.expired ()) entries_.erase (e++);
+          else ++e;
+        }
+
+        Entry& entry = entries_[path.get ()];
+        entry.path = path;
+        entry.numberPaths = path->numberPaths ();
+        entry.length = path->length ();
+        entry.timeline = compute (path);
+        return entry.timeline;
+      }
+
+      EdgeTimelines::TimelinePtr_t EdgeTimelines::compute
+      (const core::PathVectorPtr_t& path)
+      {
+        core::PathVectorPtr_t flat = core::PathVector::create
+          (path->outputSize (), path->outputDerivativeSize ());
+        path->flatten (flat);
+
+        boost::shared_ptr <Timeline> res (new Timeline);
+        res->bounds.reserve (flat->numberPaths () + 1);
+        res->edges.reserve (flat->numberPaths ());
+        core::value_type t = flat->timeRange ().first;
+        res->bounds.push_back (t);
+        for (std::size_t i = 0; i < flat->numberPaths (); ++i) {
+          core::PathPtr_t p = flat->pathAtRank (i);
+          t += p->length ();
+          res->bounds.push_back (t);
+          ConstraintSetPtr_t constraint =
+            HPP_DYNAMIC_PTR_CAST (ConstraintSet, p->constraints ());
+          if (constraint && constraint->edge ())
+            res->edges.push_back ((long) constraint->edge ()->id ());
+          else
+            res->edges.push_back (-1);
+        }
+        return res;
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,73 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_EDGE_TIMELINES_HH
+# define HPP_MANIPULATION_CORBA_EDGE_TIMELINES_HH
+
+# include <map>
+# include <vector>
+
+# include <boost/shared_ptr.hpp>
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/core/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Edges of the constraint graph along paths.
+      ///
+      /// The timeline of a path is computed the first time it is requested
+      /// and kept as long as the path exists and is not modified.
+      class EdgeTimelines
+      {
+        public:
+          struct Timeline {
+            /// Parameter at which each flattened sub-path starts, followed
+            /// by the end parameter of the path.
+            std::vector <core::value_type> bounds;
+            /// Edge ID of each sub-path, -1 if the sub-path has no edge
+            /// information.
+            std::vector <long> edges;
+
+            /// Rank of the sub-path at a parameter, as
+            /// core::PathVector::rankAtParam.
+            std::size_t rank (const core::value_type& param) const;
+          };
+          typedef boost::shared_ptr <const Timeline> TimelinePtr_t;
+
+          TimelinePtr_t get (const core::PathVectorPtr_t& path);
+
+        private:
+          struct Entry {
+            core::PathVectorWkPtr_t path;
+            std::size_t numberPaths;
+            core::value_type length;
+            TimelinePtr_t timeline;
+          };
+          typedef std::map <const core::PathVector*, Entry> Entries_t;
+
+          static TimelinePtr_t compute (const core::PathVectorPtr_t& path);
+
+          Entries_t entries_;
+          boost::mutex mutex_;
+      }; // class EdgeTimelines
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_EDGE_TIMELINES_HH
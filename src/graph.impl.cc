@@ -43,6 +43,10 @@
 #include <hpp/corbaserver/manipulation/server.hh>
 
 #include "tools.hh"
+#include "thread-pool.hh"
+#include "projection-profiler.hh"
+#include "roadmap-index.hh"
+#include "problem-locks.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -54,6 +58,8 @@ namespace hpp {
       using graph::EdgePtr_t;
       using graph::LevelSetEdgePtr_t;
       using graph::WaypointEdgePtr_t;
+      using hpp::corbaserver::manipulation::StateDescription;
+      using hpp::corbaserver::manipulation::EdgeDescription;
 
       using corbaServer::floatSeqToConfig;
 
@@ -100,6 +106,73 @@ namespace hpp {
           out.handles_  = toStringVector (in.handles );
           out.link_ = in.link;
         }
+
+        void toProjectorProfile (std::size_t id,
+            const ProjectionProfiler::Profile& in, ProjectorProfile& out)
+        {
+          out.id = (ID) id;
+          out.nbApply = (Long) in.nbApply;
+          out.nbSuccess = (Long) in.nbSuccess;
+          out.totalTime = in.totalTime;
+          out.maxTime = in.maxTime;
+          out.nbWarmStart = (Long) in.nbWarmStart;
+          out.nbWarmStartSuccess = (Long) in.nbWarmStartSuccess;
+          out.warmStartTime = in.warmStartTime;
+          const std::vector <value_type>& tb (ProjectionProfiler::timeBounds ());
+          const std::vector <value_type>& rb
+            (ProjectionProfiler::residualBounds ());
+          out.timeBounds.length ((ULong) tb.size ());
+          for (std::size_t i = 0; i < tb.size (); ++i)
+            out.timeBounds[(ULong) i] = tb[i];
+          out.residualBounds.length ((ULong) rb.size ());
+          for (std::size_t i = 0; i < rb.size (); ++i)
+            out.residualBounds[(ULong) i] = rb[i];
+          out.timeHistogram.length ((ULong) in.timeHistogram.size ());
+          for (std::size_t i = 0; i < in.timeHistogram.size (); ++i)
+            out.timeHistogram[(ULong) i] = (Long) in.timeHistogram[i];
+          out.residualHistogram.length ((ULong) in.residualHistogram.size ());
+          for (std::size_t i = 0; i < in.residualHistogram.size (); ++i)
+            out.residualHistogram[(ULong) i] = (Long) in.residualHistogram[i];
+        }
+
+        /// Find the state of configurations, with one copy of the state
+        /// constraints per thread.
+        struct GetStates
+        {
+          typedef std::vector <ConstraintSetPtr_t> Constraints_t;
+
+          GetStates (const Constraints_t& constraints,
+              std::vector <Constraints_t>& copies,
+              const std::vector <Configuration_t>& qs, bool withErrors,
+              std::vector <long>& states, vector_t& errors) :
+            constraints_ (constraints), copies_ (copies), qs_ (qs),
+            withErrors_ (withErrors), states_ (states), errors_ (errors)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            Constraints_t& cs = copies_[thread];
+            vector_t error;
+            for (std::size_t j = 0; j < constraints_.size (); ++j) {
+              if (!cs[j]) cs[j] = copyConstraintSet (constraints_[j]);
+              bool satisfied = withErrors_ ?
+                cs[j]->isSatisfied (qs_[i], error) :
+                cs[j]->isSatisfied (qs_[i]);
+              if (satisfied) {
+                states_[i] = (long) j;
+                if (withErrors_) errors_[i] = error.norm ();
+                return;
+              }
+            }
+          }
+
+          const Constraints_t& constraints_;
+          std::vector <Constraints_t>& copies_;
+          const std::vector <Configuration_t>& qs_;
+          bool withErrors_;
+          std::vector <long>& states_;
+          vector_t& errors_;
+        }; // struct GetStates
       }
 
       std::vector <std::string>
@@ -117,8 +190,19 @@ namespace hpp {
         return toStringVector (names);
       }
 
+      namespace {
+        /// Passive dofs of n constraints, possibly not specified.
+        std::vector <std::string> passiveDofNames (const hpp::Names_t& names,
+            const size_t& n)
+        {
+          if (names.length () == 0)
+            return std::vector <std::string> (n);
+          return convertPassiveDofNameVector (names, n);
+        }
+      }
+
       Graph::Graph () :
-        server_ (0x0)
+        server_ (0x0), initTime_ (0)
       {}
 
       ProblemSolverPtr_t Graph::problemSolver ()
@@ -153,6 +237,7 @@ namespace hpp {
       Long Graph::createGraph(const char* graphName)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         DevicePtr_t robot = problemSolver()->robot ();
         if (!robot) throw Error ("Build the robot first.");
 	// Create default steering method to store in edges, until we define a
@@ -169,6 +254,7 @@ namespace hpp {
       Long Graph::createSubGraph(const char* subgraphName)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::GuidedStateSelectorPtr_t ns = graph::GuidedStateSelector::create
           (subgraphName, problemSolver()->roadmap ());
         graph()->stateSelector(ns);
@@ -178,6 +264,7 @@ namespace hpp {
       void Graph::setTargetNodeList(const ID subgraph, const hpp::IDseq& nodes)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::GuidedStateSelectorPtr_t ns = getComp <graph::GuidedStateSelector> (subgraph);
         try {
           graph::States_t nl;
@@ -187,12 +274,14 @@ namespace hpp {
         } catch (std::out_of_range& e) {
           throw Error (e.what());
         }
+        touch (ns->id ());
       }
 
       Long Graph::createNode(const Long subgraphId, const char* nodeName,
           const bool waypoint, const Long priority)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::StateSelectorPtr_t ns = getComp <graph::StateSelector> (subgraphId);
 
         graph::StatePtr_t state = ns->createState (nodeName, waypoint, priority);
@@ -202,6 +291,7 @@ namespace hpp {
       Long Graph::createEdge(const Long nodeFromId, const Long nodeToId, const char* edgeName, const Long w, const Long isInNodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::StatePtr_t from = getComp <graph::State> (nodeFromId),
 	  to = getComp <graph::State> (nodeToId),
 	  isInState = getComp <graph::State> (isInNodeId);
@@ -218,6 +308,7 @@ namespace hpp {
           const Long isInNodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::StatePtr_t from = getComp <graph::State> (nodeFromId),
 	  to = getComp <graph::State> (nodeToId),
 	  isInNode = getComp <graph::State> (isInNodeId);
@@ -237,6 +328,7 @@ namespace hpp {
           const ID edgeId, const ID nodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         WaypointEdgePtr_t we = getComp <graph::WaypointEdge> (waypointEdgeId);
         EdgePtr_t edge = getComp <Edge> (edgeId);
         graph::StatePtr_t state = getComp <graph::State> (nodeId);
@@ -244,58 +336,134 @@ namespace hpp {
         if (index < 0 || (std::size_t)index > we->nbWaypoints ())
           throw Error ("Invalid index");
         we->setWaypoint (index, edge, state);
+        touch (we->id ());
+      }
+
+      void Graph::touch (std::size_t id)
+      {
+        boost::mutex::scoped_lock lock (revisionMutex_);
+        graph::GraphPtr_t g = graph (false);
+        if (!g) return;
+        updateRevisions (g);
+        if (id >= revisions_.modified.size ()) return;
+        revisions_.modified[id] = ++revisions_.current;
+      }
+
+      void Graph::updateRevisions (const graph::GraphPtr_t& g)
+      {
+        Revisions& r (revisions_);
+        if (r.graph.lock () != g) {
+          r.graph = g;
+          r.reset = ++r.current;
+          r.modified.clear ();
+          r.kinds.clear ();
+        }
+        std::size_t n = g->nbComponents ();
+        if (r.modified.size () >= n) return;
+
+        Long rev = (r.modified.empty () ? r.current : ++r.current);
+        r.modified.resize (n, rev);
+        for (std::size_t i = r.kinds.size (); i < n; ++i) {
+          graph::GraphComponentPtr_t comp = g->get(i).lock();
+          if (HPP_DYNAMIC_PTR_CAST (graph::State, comp))
+            r.kinds.push_back (StateKind);
+          else if (HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge, comp))
+            r.kinds.push_back (WaypointEdgeKind);
+          else if (HPP_DYNAMIC_PTR_CAST (graph::Edge, comp))
+            r.kinds.push_back (EdgeKind);
+          else
+            r.kinds.push_back (OtherKind);
+        }
+      }
+
+      bool Graph::graphElements (const graph::GraphPtr_t& g,
+          Long sinceRevision, GraphElements& elmts)
+      {
+        std::vector <std::size_t> states, edges;
+        std::vector <bool> waypoint;
+        bool full;
+        {
+          boost::mutex::scoped_lock lock (revisionMutex_);
+          updateRevisions (g);
+          full = (sinceRevision < revisions_.reset);
+          for (std::size_t i = 0; i < revisions_.modified.size (); ++i) {
+            if (i == g->id ()) continue;
+            if (!full && revisions_.modified[i] <= sinceRevision) continue;
+            switch (revisions_.kinds[i]) {
+              case StateKind: states.push_back (i); break;
+              case EdgeKind:
+              case WaypointEdgeKind:
+                edges.push_back (i);
+                waypoint.push_back (revisions_.kinds[i] == WaypointEdgeKind);
+                break;
+              default: break;
+            }
+          }
+        }
+
+        elmts.nodes.length ((ULong) states.size ());
+        for (std::size_t i = 0; i < states.size (); ++i) {
+          graph::GraphComponentPtr_t comp = g->get(states[i]).lock();
+          GraphComp& current = elmts.nodes[(ULong) i];
+          current.name = comp->name ().c_str ();
+          current.id   = (Long) comp->id ();
+        }
+
+        elmts.edges.length ((ULong) edges.size ());
+        for (std::size_t i = 0; i < edges.size (); ++i) {
+          graph::EdgePtr_t e = HPP_STATIC_PTR_CAST (graph::Edge,
+              g->get(edges[i]).lock());
+          GraphComp& current = elmts.edges[(ULong) i];
+          current.name = e->name ().c_str ();
+          current.id   = (Long) e->id ();
+          if (waypoint[i]) {
+            graph::WaypointEdgePtr_t we = HPP_STATIC_PTR_CAST (
+                graph::WaypointEdge, e);
+            current.waypoints.length((ULong)we->nbWaypoints());
+            for (std::size_t j = 0; j < we->nbWaypoints(); ++j)
+              current.waypoints[(ULong)j] = (ID)we->waypoint(j)->to()->id();
+          } else {
+            current.waypoints.length(0);
+          }
+          current.start = (Long) e->from ()->id ();
+          current.end = (Long) e->to ()->id ();
+        }
+        return full;
       }
 
       void Graph::getGraph (GraphComp_out graph_out, GraphElements_out elmts)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::GraphPtr_t g = graph();
-        GraphComps_t comp_n, comp_e;
-        GraphComp comp_g, current;
+        try {
+          // Set the graph values
+          graph_out = new GraphComp ();
+          graph_out->name = g->name ().c_str();
+          graph_out->id = (Long) g->id ();
 
-        graph::StatePtr_t n;
-        graph::EdgePtr_t e;
+          elmts = new GraphElements;
+          graphElements (g, -1, *elmts);
+        } catch (std::out_of_range& e) {
+          throw Error (e.what());
+        }
+      }
 
-        ULong len_edges = 0;
-        ULong len_nodes = 0;
+      Long Graph::getGraphDelta (Long sinceRevision, GraphComp_out graph_out,
+          GraphElements_out elmts, CORBA::Boolean& full)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        graph::GraphPtr_t g = graph();
         try {
-          // Set the graph values
           graph_out = new GraphComp ();
           graph_out->name = g->name ().c_str();
           graph_out->id = (Long) g->id ();
 
-          for (std::size_t i = 0; i < g->nbComponents(); ++i) {
-            if (i == g->id ()) continue;
-            graph::GraphComponentPtr_t gcomponent = g->get(i).lock();
-            if (!gcomponent) continue;
-            current.name = gcomponent->name ().c_str ();
-            current.id   = (Long) gcomponent->id ();
-            n = HPP_DYNAMIC_PTR_CAST(graph::State, gcomponent);
-            e = HPP_DYNAMIC_PTR_CAST(graph::Edge, gcomponent);
-            if (n) {
-              comp_n.length (len_nodes + 1);
-              comp_n[len_nodes] = current;
-              len_nodes++;
-            } else if (e) {
-              comp_e.length (len_edges + 1);
-              graph::WaypointEdgePtr_t we = HPP_DYNAMIC_PTR_CAST (
-                  graph::WaypointEdge, e);
-              if (we) {
-                current.waypoints.length((ULong)we->nbWaypoints());
-                for (std::size_t i = 0; i < we->nbWaypoints(); ++i)
-                  current.waypoints[(ULong)i] = (ID)we->waypoint(i)->to()->id();
-              } else {
-                current.waypoints.length(0);
-              }
-              current.start = (Long) e->from ()->id ();
-              current.end = (Long) e->to ()->id ();
-              comp_e[len_edges] = current;
-              len_edges++;
-            }
-          }
           elmts = new GraphElements;
-          elmts->nodes = comp_n;
-          elmts->edges = comp_e;
+          full = graphElements (g, sinceRevision, *elmts);
+          boost::mutex::scoped_lock lock (revisionMutex_);
+          return revisions_.current;
         } catch (std::out_of_range& e) {
           throw Error (e.what());
         }
@@ -304,6 +472,7 @@ namespace hpp {
       void Graph::getEdgeStat (ID edgeId, Names_t_out reasons, intSeq_out freqs)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId, true);
         core::PathPlannerPtr_t p = problemSolver()->pathPlanner ();
         if (!p) throw Error ("There is no planner");
@@ -321,23 +490,60 @@ namespace hpp {
         freqs = f_ptr;
       }
 
+      void Graph::getAllEdgeStats (intSeq_out edgeIds, Names_t_out reasons,
+          intSeqSeq_out freqs)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        graph::GraphPtr_t g = graph ();
+        core::PathPlannerPtr_t p = problemSolver()->pathPlanner ();
+        if (!p) throw Error ("There is no planner");
+        ManipulationPlannerPtr_t mp =
+          HPP_DYNAMIC_PTR_CAST (ManipulationPlanner, p);
+        if (!mp) throw Error ("The planner must be a ManipulationPlanner");
+
+        std::vector <std::size_t> ids;
+        {
+          boost::mutex::scoped_lock lock (revisionMutex_);
+          updateRevisions (g);
+          for (std::size_t i = 0; i < revisions_.kinds.size (); ++i)
+            if (revisions_.kinds[i] == EdgeKind
+                || revisions_.kinds[i] == WaypointEdgeKind)
+              ids.push_back (i);
+        }
+
+        StringList_t errors = ManipulationPlanner::errorList ();
+        intSeqSeq* f_ptr = new intSeqSeq ();
+        f_ptr->length ((ULong) ids.size ());
+        try {
+          for (std::size_t i = 0; i < ids.size (); ++i) {
+            graph::EdgePtr_t edge = HPP_STATIC_PTR_CAST (graph::Edge,
+                g->get (ids[i]).lock ());
+            ManipulationPlanner::ErrorFreqs_t fes = mp->getEdgeStat (edge);
+            intSeq& row = (*f_ptr)[(ULong) i];
+            row.length ((ULong) fes.size ());
+            for (std::size_t j = 0; j < fes.size (); ++j)
+              row[(ULong) j] = (CORBA::Long) fes[j];
+          }
+        } catch (const std::exception& exc) {
+          delete f_ptr;
+          throw Error (exc.what ());
+        }
+
+        edgeIds = toIntSeq (ids.begin (), ids.end ());
+        reasons = toNames_t (errors.begin (), errors.end());
+        freqs = f_ptr;
+      }
+
       Long Graph::getFrequencyOfNodeInRoadmap (ID nodeId, intSeq_out freqPerConnectedComponent)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::StatePtr_t state = getComp <graph::State> (nodeId, true);
         // Long nb = graph_->nodeHistogram()->freq(graph::NodeBin(node));
-        std::size_t nb = 0;
-        const core::ConnectedComponents_t& ccs = problemSolver()->roadmap ()->connectedComponents();
-        core::ConnectedComponents_t::const_iterator _cc;
         std::vector<std::size_t> freqs;
-        for (_cc = ccs.begin(); _cc != ccs.end(); ++_cc) {
-          manipulation::ConnectedComponentPtr_t cc =
-            HPP_DYNAMIC_PTR_CAST(manipulation::ConnectedComponent, *_cc);
-          if (!cc)
-            throw Error ("Connected component is not of the right type.");
-          freqs.push_back(cc->getRoadmapNodes(state).size());
-          nb += freqs.back();
-        }
+        std::size_t nb = server_->roadmapIndex ().frequencies
+          (problemSolver()->roadmap (), state, freqs);
         freqPerConnectedComponent = toIntSeq(freqs.begin(), freqs.end());
         return (Long) nb;
       }
@@ -346,6 +552,7 @@ namespace hpp {
           ConfigProjStat_out path)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::StatePtr_t state = getComp <graph::State> (elmt, false);
         graph::EdgePtr_t edge = getComp <graph::Edge> (elmt, false);
         if (state) {
@@ -381,10 +588,51 @@ namespace hpp {
         return false;
       }
 
+      ProjectorProfile* Graph::getProjectorProfile (ID elmt)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        graph::GraphComponentPtr_t comp =
+          getComp <graph::GraphComponent> (elmt, true);
+        ProjectionProfiler::Profiles_t profiles =
+          server_->projectionProfiler ().profiles (graph ());
+        ProjectionProfiler::Profiles_t::const_iterator _p =
+          profiles.find (comp->id ());
+
+        ProjectorProfile* profile = new ProjectorProfile ();
+        toProjectorProfile (comp->id (), _p == profiles.end () ?
+            ProjectionProfiler::Profile () : _p->second, *profile);
+        return profile;
+      }
+
+      ProjectorProfiles* Graph::getProjectorProfiles ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        ProjectionProfiler::Profiles_t profiles =
+          server_->projectionProfiler ().profiles (graph ());
+
+        ProjectorProfiles* ret = new ProjectorProfiles ();
+        ret->length ((ULong) profiles.size ());
+        ULong i = 0;
+        for (ProjectionProfiler::Profiles_t::const_iterator _p =
+            profiles.begin (); _p != profiles.end (); ++_p, ++i)
+          toProjectorProfile (_p->first, _p->second, (*ret)[i]);
+        return ret;
+      }
+
+      void Graph::resetProjectorProfiles ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        server_->projectionProfiler ().reset (graph ());
+      }
+
       Long Graph::getWaypoint (const Long edgeId, const Long index,
           hpp::ID_out nodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::WaypointEdgePtr_t edge = getComp <graph::WaypointEdge> (edgeId);
 
         if (index < 0 || (std::size_t)index > edge->nbWaypoints ())
@@ -397,6 +645,7 @@ namespace hpp {
       Long Graph::createLevelSetEdge(const Long nodeFromId, const Long nodeToId, const char* edgeName, const Long w, const ID isInNodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::StatePtr_t from      = getComp <graph::State> (nodeFromId),
                           to        = getComp <graph::State> (nodeToId  ),
 	                  isInState = getComp <graph::State> (isInNodeId);
@@ -416,14 +665,13 @@ namespace hpp {
           const hpp::Names_t& paramLJ)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::LevelSetEdgePtr_t edge = getComp <graph::LevelSetEdge> (edgeId);
         try {
           for (CORBA::ULong i=0; i<condNC.length (); ++i) {
             std::string name (condNC [i]);
             edge->insertConditionConstraint
-              (HPP_STATIC_PTR_CAST(NumericalConstraint,
-                                   problemSolver()->get
-                                   <NumericalConstraintPtr_t>(name)->copy ()));
+              (constraintPool_.get (graph (), problemSolver(), name));
           }
           for (CORBA::ULong i=0; i<condLJ.length (); ++i) {
             std::string name (condLJ [i]);
@@ -436,8 +684,7 @@ namespace hpp {
           for (CORBA::ULong i=0; i<paramNC.length (); ++i) {
             std::string name (paramNC [i]);
             edge->insertParamConstraint (
-                HPP_STATIC_PTR_CAST(NumericalConstraint,
-                problemSolver()->get <NumericalConstraintPtr_t>(name)->copy ()),
+                constraintPool_.get (graph (), problemSolver(), name),
                 problemSolver()->passiveDofs (pdofNames [i]));
           }
           for (CORBA::ULong i=0; i<paramLJ.length (); ++i) {
@@ -450,11 +697,13 @@ namespace hpp {
         } catch (std::exception& err) {
           throw Error (err.what());
         }
+        touch (edge->id ());
       }
 
       void Graph::setContainingNode (const ID edgeId, const ID nodeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         graph::StatePtr_t state = getComp <graph::State> (nodeId);
         try {
@@ -462,11 +711,13 @@ namespace hpp {
         } catch (std::exception& err) {
           throw Error (err.what());
         }
+        touch (edge->id ());
       }
 
       char* Graph::getContainingNode (const ID edgeId)
             throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         try {
 	  std::string name (edge->state ()->name ());
@@ -483,6 +734,7 @@ namespace hpp {
           const hpp::Names_t& passiveDofsNames)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::GraphComponentPtr_t component = getComp<graph::GraphComponent>(graphComponentId, true);
 
         if (constraintNames.length () > 0) {
@@ -494,20 +746,20 @@ namespace hpp {
               if (!problemSolver()->numericalConstraint (name))
                 throw Error ("The numerical function does not exist.");
               component->addNumericalConstraint
-		(HPP_STATIC_PTR_CAST
-		 (NumericalConstraint,
-		  problemSolver()->numericalConstraint(name)->copy ()),
+		(constraintPool_.get (graph (), problemSolver(), name),
 		 problemSolver()->passiveDofs (pdofNames [i]));
             }
           } catch (std::exception& err) {
             throw Error (err.what());
           }
+          touch (component->id ());
         }
       }
 
       void Graph::getNumericalConstraints(const Long graphComponentId, hpp::Names_t_out names)
 	throw(hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
 	graph::GraphComponentPtr_t elmt = getComp<graph::GraphComponent>(graphComponentId);
 	core::NumericalConstraints_t constraints = elmt->numericalConstraints();
 	names = new hpp::Names_t;
@@ -523,6 +775,7 @@ namespace hpp {
       void Graph::getLockedJoints(const Long graphComponentId, hpp::Names_t_out names)
 	throw(hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
 	graph::GraphComponentPtr_t elmt = getComp<graph::GraphComponent>(graphComponentId, true);
 	core::LockedJoints_t lockedJoints = elmt->lockedJoints();
 	names = new hpp::Names_t;
@@ -537,10 +790,12 @@ namespace hpp {
 
       void Graph::resetConstraints(const Long graphComponentId) throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::GraphComponentPtr_t component =
           getComp<graph::GraphComponent>(graphComponentId, true);
 	component->resetNumericalConstraints();
 	component->resetLockedJoints();
+        touch (component->id ());
       }
 
       void Graph::addNumericalConstraintsForPath (const Long nodeId,
@@ -548,6 +803,7 @@ namespace hpp {
           const hpp::Names_t& passiveDofsNames)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::StatePtr_t n = getComp <graph::State> (nodeId);
 
         if (constraintNames.length () > 0) {
@@ -557,14 +813,13 @@ namespace hpp {
             for (CORBA::ULong i=0; i<constraintNames.length (); ++i) {
               std::string name (constraintNames [i]);
               n->addNumericalConstraintForPath
-		(HPP_STATIC_PTR_CAST
-		 (NumericalConstraint,
-		  problemSolver()->numericalConstraint(name)->copy ()),
+		(constraintPool_.get (graph (), problemSolver(), name),
 		 problemSolver()->passiveDofs (pdofNames [i]));
             }
           } catch (std::exception& err) {
             throw Error (err.what());
           }
+          touch (n->id ());
         }
       }
 
@@ -572,6 +827,7 @@ namespace hpp {
           const hpp::Names_t& constraintNames)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::GraphComponentPtr_t component = getComp<graph::GraphComponent>(graphComponentId, true);
 
         if (constraintNames.length () > 0) {
@@ -584,12 +840,25 @@ namespace hpp {
           } catch (std::exception& err) {
             throw Error (err.what());
           }
+          touch (component->id ());
         }
       }
 
+      void Graph::getConstraintPoolStats (Long& size, Long& hits,
+          Long& copies)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        graph::GraphPtr_t g = graph ();
+        size = (Long) constraintPool_.size (g);
+        hits = (Long) constraintPool_.hits (g);
+        copies = (Long) constraintPool_.copies (g);
+      }
+
       void Graph::getNode (const hpp::floatSeq& dofArray, ID_out output)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         DevicePtr_t robot = getRobotOrThrow (problemSolver());
         try {
           Configuration_t config (floatSeqToConfig (robot, dofArray, true));
@@ -600,10 +869,54 @@ namespace hpp {
         }
       }
 
+      Long Graph::getNodes (const hpp::floatSeqSeq& dofArrays,
+          CORBA::Boolean withErrors, hpp::intSeq_out nodeIds,
+          hpp::floatSeq_out errors)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        graph::GraphPtr_t g = graph();
+        DevicePtr_t robot = getRobotOrThrow (problemSolver());
+        try {
+          std::vector <Configuration_t> qs = floatSeqSeqToConfigs
+            (robot, dofArrays);
+
+          // States in the order used by graph::Graph::getState.
+          // Their constraints are built here, not in the workers.
+          graph::States_t states = g->stateSelector ()->getStates ();
+          GetStates::Constraints_t constraints (states.size ());
+          for (std::size_t j = 0; j < states.size (); ++j)
+            constraints[j] = states[j]->configConstraint ();
+
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          std::vector <GetStates::Constraints_t> copies (pool.size (),
+              GetStates::Constraints_t (states.size ()));
+          std::vector <long> stateIndexes (qs.size (), -1);
+          vector_t errs (vector_t::Zero (withErrors ? qs.size () : 0));
+          pool.parallelFor (qs.size (), GetStates (constraints, copies, qs,
+                withErrors, stateIndexes, errs));
+
+          std::vector <long> ids (qs.size (), -1);
+          std::size_t nb = 0;
+          for (std::size_t i = 0; i < qs.size (); ++i) {
+            if (stateIndexes[i] < 0) continue;
+            ids[i] = (long) states[stateIndexes[i]]->id ();
+            ++nb;
+          }
+          nodeIds = toIntSeq (ids.begin (), ids.end ());
+          errors = vectorToFloatSeq (errs);
+          return (Long) nb;
+        } catch (const std::exception& exc) {
+          throw Error (exc.what ());
+        }
+      }
+
       CORBA::Boolean Graph::getConfigErrorForNode
       (ID nodeId, const hpp::floatSeq& dofArray, hpp::floatSeq_out error)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	graph::StatePtr_t state = getComp <graph::State> (nodeId);
         DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	try {
@@ -621,6 +934,7 @@ namespace hpp {
       (ID edgeId, const hpp::floatSeq& dofArray, hpp::floatSeq_out error)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	try {
 	  graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
@@ -651,6 +965,7 @@ namespace hpp {
        const hpp::floatSeq& dofArray, hpp::floatSeq_out error)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	try {
 	  graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
@@ -681,6 +996,7 @@ namespace hpp {
       void Graph::displayNodeConstraints
       (hpp::ID nodeId, CORBA::String_out constraints) throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	graph::StatePtr_t state = getComp <graph::State> (nodeId);
 	ConstraintSetPtr_t cs (graph()->configConstraint (state));
 	std::ostringstream oss;
@@ -691,6 +1007,7 @@ namespace hpp {
       void Graph::displayEdgeTargetConstraints
       (hpp::ID edgeId, CORBA::String_out constraints) throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
 	ConstraintSetPtr_t cs (graph()->configConstraint (edge));
 	std::ostringstream oss;
@@ -701,6 +1018,7 @@ namespace hpp {
       void Graph::displayEdgeConstraints
       (hpp::ID edgeId, CORBA::String_out constraints) throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
 	ConstraintSetPtr_t cs (graph()->pathConstraint (edge));
 	std::ostringstream oss;
@@ -712,6 +1030,8 @@ namespace hpp {
        (hpp::ID edgeId, CORBA::String_out from, CORBA::String_out to)
 	 throw (Error)
        {
+         ProblemLocks::Lock lock (server_, ProblemLocks::Read,
+             problemName_);
 	 graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
 	 from = edge->from ()->name ().c_str ();
 	 to = edge->to ()->name ().c_str ();
@@ -720,6 +1040,7 @@ namespace hpp {
       void Graph::display (const char* filename)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         std::cout << *graph();
         std::ofstream dotfile;
         dotfile.open (filename);
@@ -731,6 +1052,7 @@ namespace hpp {
           hpp::floatSeqSeq_out values)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::LevelSetEdgePtr_t edge = getComp <graph::LevelSetEdge> (edgeId);
         try {
           graph::LeafHistogramPtr_t hist = edge->histogram ();
@@ -760,17 +1082,20 @@ namespace hpp {
       void Graph::setShort (ID edgeId, CORBA::Boolean isShort)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         try {
           edge->setShort (isShort);
 	} catch (const std::exception& exc) {
 	  throw Error (exc.what ());
 	}
+        touch (edge->id ());
       }
 
       bool Graph::isShort (ID edgeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         try {
           return edge->isShort ();
@@ -789,6 +1114,7 @@ namespace hpp {
 	  const Rules& rulesList)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	std::vector<graph::helper::Rule> rules(rulesList.length());
 
 	for (ULong i = 0; i < rulesList.length(); ++i) {
@@ -815,20 +1141,190 @@ namespace hpp {
         }
       }
 
+      void Graph::checkDescription (const GraphDescription& d)
+      {
+        Long nStates = (Long) d.states.length (),
+             nEdges = (Long) d.edges.length ();
+        for (ULong i = 0; i < d.edges.length (); ++i) {
+          const EdgeDescription& ed (d.edges[i]);
+          std::ostringstream oss;
+          oss << "Edge " << i << " (" << ed.name << "): ";
+          if (ed.from < 0 || ed.from >= nStates
+              || ed.to < 0 || ed.to >= nStates
+              || ed.containingState < 0 || ed.containingState >= nStates)
+            throw std::invalid_argument (oss.str () + "invalid state index.");
+          if (!ed.waypointEdge) {
+            if (ed.waypointEdges.length () > 0)
+              throw std::invalid_argument (oss.str () +
+                  "only waypoint edges have waypoints.");
+            continue;
+          }
+          if (ed.nbWaypoints < 0
+              || ed.waypointEdges.length () > (ULong) ed.nbWaypoints + 1
+              || ed.waypointStates.length () != ed.waypointEdges.length ())
+            throw std::invalid_argument (oss.str () +
+                "invalid number of waypoints.");
+          for (ULong j = 0; j < ed.waypointEdges.length (); ++j) {
+            if (ed.waypointEdges[j] < 0 || ed.waypointEdges[j] >= nEdges
+                || ed.waypointStates[j] < 0
+                || ed.waypointStates[j] >= nStates)
+              throw std::invalid_argument (oss.str () +
+                  "invalid waypoint index.");
+          }
+        }
+      }
+
+      void Graph::addConstraints (const ProblemSolverPtr_t& ps,
+          ConstraintPool& pool, const graph::GraphPtr_t& g,
+          const graph::GraphComponentPtr_t& comp,
+          const ComponentConstraints& constraints)
+      {
+        std::vector <std::string> pdofNames = passiveDofNames
+          (constraints.passiveDofs, constraints.numerical.length ());
+        for (ULong i = 0; i < constraints.numerical.length (); ++i)
+          comp->addNumericalConstraint (pool.get (g, ps,
+                std::string (constraints.numerical[i])),
+              ps->passiveDofs (pdofNames[i]));
+        for (ULong i = 0; i < constraints.lockedJoints.length (); ++i)
+          comp->addLockedJointConstraint (ps->get <LockedJointPtr_t>
+              (std::string (constraints.lockedJoints[i])));
+      }
+
+      graph::GraphPtr_t Graph::buildGraph (const ProblemSolverPtr_t& ps,
+          const GraphDescription& d, ConstraintPool& pool,
+          std::vector <graph::StatePtr_t>& states,
+          std::vector <EdgePtr_t>& edges)
+      {
+        DevicePtr_t robot = getRobotOrThrow (ps);
+        checkDescription (d);
+
+        std::string name (d.name);
+        graph::GraphPtr_t g = graph::Graph::create(name, robot,
+            ps->problem());
+        g->maxIterations (ps->maxIterProjection ());
+        g->errorThreshold (ps->errorThreshold ());
+        graph::GuidedStateSelectorPtr_t ns =
+          graph::GuidedStateSelector::create (name + "_sg", ps->roadmap ());
+        g->stateSelector(ns);
+
+        states.resize (d.states.length ());
+        for (ULong i = 0; i < d.states.length (); ++i)
+          states[i] = ns->createState (std::string (d.states[i].name),
+              d.states[i].waypoint, d.states[i].priority);
+
+        edges.resize (d.edges.length ());
+        for (ULong i = 0; i < d.edges.length (); ++i) {
+          const EdgeDescription& ed (d.edges[i]);
+          edges[i] = states[ed.from]->linkTo (std::string (ed.name),
+              states[ed.to], (size_type) ed.weight, ed.waypointEdge ?
+              (graph::State::EdgeFactory)WaypointEdge::create :
+              (graph::State::EdgeFactory)Edge::create);
+          edges[i]->state (states[ed.containingState]);
+          if (ed.waypointEdge)
+            HPP_STATIC_PTR_CAST (WaypointEdge, edges[i])->nbWaypoints
+              (ed.nbWaypoints);
+        }
+        for (ULong i = 0; i < d.edges.length (); ++i) {
+          const EdgeDescription& ed (d.edges[i]);
+          for (ULong j = 0; j < ed.waypointEdges.length (); ++j)
+            HPP_STATIC_PTR_CAST (WaypointEdge, edges[i])->setWaypoint
+              (j, edges[ed.waypointEdges[j]], states[ed.waypointStates[j]]);
+        }
+
+        addConstraints (ps, pool, g, g, d.constraints);
+        for (ULong i = 0; i < d.states.length (); ++i) {
+          const StateDescription& sd (d.states[i]);
+          addConstraints (ps, pool, g, states[i], sd.constraints);
+          std::vector <std::string> pdofNames = passiveDofNames
+            (sd.pathPassiveDofs, sd.pathConstraints.length ());
+          for (ULong j = 0; j < sd.pathConstraints.length (); ++j)
+            states[i]->addNumericalConstraintForPath
+              (pool.get (g, ps, std::string (sd.pathConstraints[j])),
+               ps->passiveDofs (pdofNames[j]));
+        }
+        for (ULong i = 0; i < d.edges.length (); ++i) {
+          addConstraints (ps, pool, g, edges[i], d.edges[i].constraints);
+          if (d.edges[i].isShort) edges[i]->setShort (true);
+        }
+
+        // The servants of the problem handles keep the descriptions in the
+        // main servant, so that rebuildGraph finds all of them.
+        Graph& main (server_->graph ());
+        boost::mutex::scoped_lock lock (main.descriptionsMutex_);
+        main.descriptions_.get (g) = d;
+        return g;
+      }
+
+      graph::GraphPtr_t Graph::rebuildGraph (const ProblemSolverPtr_t& ps,
+          const graph::GraphPtr_t& source)
+      {
+        GraphDescription d;
+        {
+          boost::mutex::scoped_lock lock (descriptionsMutex_);
+          GraphDescription* found = descriptions_.find (source);
+          if (!found) return graph::GraphPtr_t ();
+          d = *found;
+        }
+        // The copy may be used concurrently with the source graph, so it
+        // does not share its constraints.
+        ConstraintPool pool;
+        std::vector <graph::StatePtr_t> states;
+        std::vector <EdgePtr_t> edges;
+        graph::GraphPtr_t g = buildGraph (ps, d, pool, states, edges);
+        g->initialize ();
+        return g;
+      }
+
+      intSeq* Graph::buildGraphFromDescription (const GraphDescription& d,
+          intSeq_out stateIds, intSeq_out edgeIds)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          std::vector <graph::StatePtr_t> states;
+          std::vector <EdgePtr_t> edges;
+          graph::GraphPtr_t g = buildGraph (problemSolver(), d,
+              constraintPool_, states, edges);
+          graph::StateSelectorPtr_t ns = g->stateSelector ();
+
+          problemSolver()->constraintGraph (g);
+          problemSolver()->problem()->constraintGraph (g);
+
+          std::vector <std::size_t> ids (states.size ());
+          for (std::size_t i = 0; i < states.size (); ++i)
+            ids[i] = states[i]->id ();
+          stateIds = toIntSeq (ids.begin(), ids.end());
+          ids.resize (edges.size ());
+          for (std::size_t i = 0; i < edges.size (); ++i)
+            ids[i] = edges[i]->id ();
+          edgeIds = toIntSeq (ids.begin(), ids.end());
+
+          ids.resize (2);
+          ids[0] = g->id();
+          ids[1] = ns->id();
+          return toIntSeq (ids.begin(), ids.end());
+        } catch (const std::exception& exc) {
+          throw Error (exc.what ());
+        }
+      }
+
       void Graph::setWeight (ID edgeId, const Long weight)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         try {
           edge->from()->updateWeight (edge, weight);
 	} catch (const std::exception& exc) {
 	  throw Error (exc.what ());
 	}
+        touch (edge->id ());
       }
 
       Long Graph::getWeight (ID edgeId)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId);
         try {
           return (Long) edge->from ()->getWeight (edge);
@@ -840,16 +1336,30 @@ namespace hpp {
       void Graph::initialize ()
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        getRobotOrThrow (problemSolver());
         try {
+          Stopwatch watch;
           problemSolver ()->initConstraintGraph ();
+          boost::mutex::scoped_lock timeLock (initTimeMutex_);
+          initTime_ = watch.elapsed ();
 	} catch (const std::exception& exc) {
 	  throw Error (exc.what ());
 	}
       }
 
+      Double Graph::getInitializationTime ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        boost::mutex::scoped_lock timeLock (initTimeMutex_);
+        return initTime_;
+      }
+
       void Graph::getRelativeMotionMatrix (ID edgeId, intSeqSeq_out matrix)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         graph::EdgePtr_t edge = getComp <graph::Edge> (edgeId, true);
         matrix = matrixToIntSeqSeq(edge->relativeMotion().cast<CORBA::Long>());
       }
@@ -20,15 +20,25 @@
 # include <hpp/manipulation/problem-solver.hh>
 # include <hpp/manipulation/graph/graph.hh>
 
+# include <boost/thread/mutex.hpp>
+
 # include "hpp/corbaserver/manipulation/fwd.hh"
 # include "hpp/corbaserver/manipulation/graph.hh"
 
+# include "tools.hh"
+# include "constraint-pool.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace impl {
       using hpp::corbaserver::manipulation::Namess_t;
       using hpp::corbaserver::manipulation::Rules;
+      using hpp::corbaserver::manipulation::ProjectorProfile;
+      using hpp::corbaserver::manipulation::ProjectorProfiles;
+      using hpp::corbaserver::manipulation::ComponentConstraints;
+      using hpp::corbaserver::manipulation::GraphDescription;
       using CORBA::Long;
+      using CORBA::Double;
 
       class Graph : public virtual POA_hpp::corbaserver::manipulation::Graph
       {
@@ -39,6 +49,12 @@ namespace hpp {
             server_ = server;
           }
 
+          /// Use the problem of this name instead of the selected one.
+          void setProblemName (const std::string& name)
+          {
+            problemName_ = name;
+          }
+
           virtual Long createGraph(const char* graphName)
             throw (hpp::Error);
 
@@ -76,10 +92,19 @@ namespace hpp {
           virtual void getGraph (GraphComp_out graph, GraphElements_out elmts)
             throw (hpp::Error);
 
+          virtual Long getGraphDelta (Long sinceRevision,
+              GraphComp_out graph, GraphElements_out elmts,
+              CORBA::Boolean& full)
+            throw (hpp::Error);
+
           virtual void getEdgeStat (ID edgeId,
               Names_t_out reasons, intSeq_out freqs)
             throw (hpp::Error);
 
+          virtual void getAllEdgeStats (intSeq_out edgeIds,
+              Names_t_out reasons, intSeqSeq_out freqs)
+            throw (hpp::Error);
+
           virtual Long getFrequencyOfNodeInRoadmap (ID nodeId, intSeq_out freqPerConnectedComponent)
             throw (hpp::Error);
 
@@ -87,6 +112,15 @@ namespace hpp {
               ConfigProjStat_out path)
             throw (hpp::Error);
 
+          virtual ProjectorProfile* getProjectorProfile (ID elmt)
+            throw (hpp::Error);
+
+          virtual ProjectorProfiles* getProjectorProfiles ()
+            throw (hpp::Error);
+
+          virtual void resetProjectorProfiles ()
+            throw (hpp::Error);
+
           virtual Long getWaypoint (const Long edgeId, const Long index,
               hpp::ID_out nodeId)
             throw (hpp::Error);
@@ -168,9 +202,18 @@ namespace hpp {
                                        const hpp::Names_t& constraintNames)
             throw (hpp::Error);
 
+          virtual void getConstraintPoolStats (Long& size, Long& hits,
+              Long& copies)
+            throw (hpp::Error);
+
           virtual void getNode (const hpp::floatSeq& dofArray, ID_out output)
             throw (hpp::Error);
 
+          virtual Long getNodes (const hpp::floatSeqSeq& dofArrays,
+              CORBA::Boolean withErrors, hpp::intSeq_out nodeIds,
+              hpp::floatSeq_out errors)
+            throw (hpp::Error);
+
 	virtual CORBA::Boolean getConfigErrorForNode
 	(ID nodeId, const hpp::floatSeq& dofArray, hpp::floatSeq_out error)
 	  throw (hpp::Error);
@@ -216,6 +259,11 @@ namespace hpp {
 	      const Names_t& envNames, const Rules& rulesList)
             throw (hpp::Error);
 
+          virtual intSeq* buildGraphFromDescription
+            (const GraphDescription& description,
+             intSeq_out stateIds, intSeq_out edgeIds)
+            throw (hpp::Error);
+
           virtual void setWeight (ID edgeId, const Long weight)
             throw (hpp::Error);
 
@@ -225,14 +273,85 @@ namespace hpp {
           virtual void initialize ()
             throw (hpp::Error);
 
+          virtual Double getInitializationTime ()
+            throw (hpp::Error);
+
           virtual void getRelativeMotionMatrix (ID edgeID, intSeqSeq_out matrix)
             throw (hpp::Error);
 
+          /// Build a copy of a graph created by buildGraphFromDescription,
+          /// through any servant, for another problem solver, and
+          /// initialize it. The copy has its own constraints, but shares
+          /// their functions.
+          /// \return the new graph, or a null pointer if source was not
+          ///         built from a description.
+          graph::GraphPtr_t rebuildGraph (const ProblemSolverPtr_t& ps,
+              const graph::GraphPtr_t& source);
+
         private:
+          enum ComponentKind {
+            StateKind,
+            EdgeKind,
+            WaypointEdgeKind,
+            OtherKind
+          };
+
+          /// Revision at which each component of the current graph was
+          /// created or last modified through this servant.
+          struct Revisions {
+            Revisions () : current (0), reset (0) {}
+            graph::GraphWkPtr_t graph;
+            Long current, reset;
+            std::vector <Long> modified;
+            std::vector <ComponentKind> kinds;
+          };
+
           template <typename T> boost::shared_ptr<T> getComp(ID id, bool throwIfWrongType = true);
           ProblemSolverPtr_t problemSolver();
           graph::GraphPtr_t graph(bool throwIfNull = true);
+
+          /// Mark a component as modified.
+          void touch (std::size_t id);
+          /// Register the components created since the last call.
+          /// \note revisionMutex_ must be locked.
+          void updateRevisions (const graph::GraphPtr_t& g);
+          /// Fill elmts with the components modified after sinceRevision.
+          /// \return whether all the components were added.
+          bool graphElements (const graph::GraphPtr_t& g, Long sinceRevision,
+              GraphElements& elmts);
+
+          /// \throw std::invalid_argument if an index is out of range.
+          void checkDescription (const GraphDescription& description);
+          /// Add constraints to a component of graph g.
+          void addConstraints (const ProblemSolverPtr_t& ps,
+              ConstraintPool& pool, const graph::GraphPtr_t& g,
+              const graph::GraphComponentPtr_t& comp,
+              const ComponentConstraints& constraints);
+          /// Build a graph for ps and keep its description.
+          /// \param pool the constraints shared with other graph components.
+          graph::GraphPtr_t buildGraph (const ProblemSolverPtr_t& ps,
+              const GraphDescription& description, ConstraintPool& pool,
+              std::vector <graph::StatePtr_t>& states,
+              std::vector <graph::EdgePtr_t>& edges);
+
           Server* server_;
+          /// Name of the problem used by the requests, if not the selected
+          /// one.
+          std::string problemName_;
+          Revisions revisions_;
+          boost::mutex revisionMutex_;
+
+          /// Time spent by the last call to initialize.
+          value_type initTime_;
+          /// Protect initTime_, read by getInitializationTime under a Read
+          /// lock.
+          boost::mutex initTimeMutex_;
+
+          ConstraintPool constraintPool_;
+
+          /// Descriptions of the graphs built by buildGraphFromDescription.
+          WeakPtrMap <graph::Graph, GraphDescription> descriptions_;
+          boost::mutex descriptionsMutex_;
       }; // class Graph
     } // namespace impl
   } // namespace manipulation
@@ -35,6 +35,59 @@ class _ConstraintAndPassiveJoints (object):
     def passiveJoints (self):
         return self.passiveJoints_
 
+## Graph components recorded by a deferred ConstraintGraph.
+#
+#  Until the description is submitted, states and edges are identified by
+#  their index in lists states and edges.
+class _GraphDescription (object):
+    def __init__ (self, name):
+        self.name = name
+        self.constraints = self.newConstraints ()
+        self.states = list ()
+        self.edges = list ()
+
+    @staticmethod
+    def newConstraints ():
+        return { 'numerical': [], 'passiveDofs': [], 'lockedJoints': [] }
+
+    def addState (self, name, waypoint, priority):
+        self.states.append ({ 'name': name, 'waypoint': waypoint,
+            'priority': priority, 'constraints': self.newConstraints (),
+            'pathConstraints': [], 'pathPassiveDofs': [] })
+        return len (self.states) - 1
+
+    ## \param nb number of waypoints, None if the edge is not a waypoint edge.
+    def addEdge (self, name, nodeFrom, nodeTo, weight, isInNode, nb = None):
+        self.edges.append ({ 'name': name, 'from': nodeFrom, 'to': nodeTo,
+            'containingState': isInNode, 'weight': weight, 'isShort': False,
+            'waypointEdge': nb is not None, 'nbWaypoints': nb or 0,
+            'waypoints': dict (), 'constraints': self.newConstraints () })
+        return len (self.edges) - 1
+
+    def toCorba (self):
+        from hpp.corbaserver.manipulation import ComponentConstraints, \
+                StateDescription, EdgeDescription, GraphDescription
+        def cc (c):
+            return ComponentConstraints (c['numerical'], c['passiveDofs'],
+                    c['lockedJoints'])
+        states = [ StateDescription (s['name'], s['waypoint'], s['priority'],
+            cc (s['constraints']), s['pathConstraints'], s['pathPassiveDofs'])
+            for s in self.states ]
+        edges = list ()
+        for e in self.edges:
+            idx = sorted (e['waypoints'].keys ())
+            if idx != range (len (idx)):
+                raise RuntimeError ("Waypoints of edge " + e['name'] +
+                        " must be set from index 0 without gap.")
+            edges.append (EdgeDescription (e['name'], e['from'], e['to'],
+                e['containingState'], e['weight'], e['isShort'],
+                e['waypointEdge'], e['nbWaypoints'],
+                [ e['waypoints'][i][0] for i in idx ],
+                [ e['waypoints'][i][1] for i in idx ],
+                cc (e['constraints'])))
+        return GraphDescription (self.name, cc (self.constraints), states,
+                edges)
+
 ### Definition of a constraint graph.
 ##
 ##  This class wraps the Corba client to the server implemented by
@@ -53,7 +106,13 @@ class ConstraintGraph (object):
             'svg': ['firefox']
             }
 
-    def __init__ (self, robot, graphName, makeGraph = True):
+    ## \param makeGraph whether a new graph is created on the server, or
+    ##        the current one is fetched.
+    ## \param deferred if True, the graph is only recorded locally and
+    ##        built by the server in a single request by method submit.
+    ##        Until then, the node and edge identifiers are provisional and
+    ##        the methods that query the server must not be called.
+    def __init__ (self, robot, graphName, makeGraph = True, deferred = False):
         self.client = robot.client.manipulation
         self.clientBasic = robot.client.basic
         self.graph = robot.client.manipulation.graph
@@ -64,28 +123,62 @@ class ConstraintGraph (object):
         self.nodes = dict ()
         ## A dictionnary mapping the edge names to their ID
         self.edges = dict ()
-        if makeGraph:
+        ## Revision of the server graph the dictionnaries are synchronized with
+        self.revision = -1
+        self._description = None
+        if deferred:
+            self._description = _GraphDescription (graphName)
+        elif makeGraph:
             self.graphId = self.graph.createGraph (graphName)
             self.subGraphId = self.graph.createSubGraph (graphName + "_sg")
         else:
             # fetch graph
             try:
-                g = self.graph.getGraph ()
-                self.graphId = g[0].id
-                self.subGraphId = self.graphId + 1
-                for n in g[1].nodes:
-                    if self.nodes.has_key(n.name):
-                        print "Erasing node", n.name, "id", self.nodes[n.name]
-                    self.nodes[n.name] = n.id
-                for e in g[1].edges:
-                    if self.edges.has_key(e.name):
-                        print "Erasing edge", e.name, "id", self.edges[e.name]
-                    self.edges[e.name] = e.id
+                self.refresh ()
             except:
                 pass
 
         self.textToTex = dict ()
 
+    ### Synchronize the node and edge dictionnaries with the server.
+    ## Only the components created or modified since the last call are
+    ## transferred, unless the graph has been replaced on the server side.
+    def refresh (self):
+        rev, g, elmts, full = self.graph.getGraphDelta (self.revision)
+        if full:
+            self.nodes = dict ()
+            self.edges = dict ()
+        self.graphId = g.id
+        self.subGraphId = self.graphId + 1
+        for n in elmts.nodes:
+            if self.nodes.get(n.name, n.id) != n.id:
+                print "Erasing node", n.name, "id", self.nodes[n.name]
+            self.nodes[n.name] = n.id
+        for e in elmts.edges:
+            if self.edges.get(e.name, e.id) != e.id:
+                print "Erasing edge", e.name, "id", self.edges[e.name]
+            self.edges[e.name] = e.id
+        self.revision = rev
+
+    ## Whether the graph is recorded locally until submit is called.
+    @property
+    def deferred (self):
+        return self._description is not None
+
+    ### Build the recorded graph on the server in a single request.
+    ## The graph replaces the current graph of the problem only if all the
+    ## components could be created. Node and edge identifiers are then
+    ## updated.
+    def submit (self):
+        if self._description is None:
+            raise RuntimeError ("The graph is not deferred.")
+        ids, stateIds, edgeIds = self.graph.buildGraphFromDescription \
+                (self._description.toCorba ())
+        self.graphId, self.subGraphId = ids
+        self.nodes = dict ((n, stateIds[i]) for n, i in self.nodes.items ())
+        self.edges = dict ((e, edgeIds[i]) for e, i in self.edges.items ())
+        self._description = None
+
     ##
     # \name Building the constraint graph
     # \{
@@ -105,7 +198,12 @@ class ConstraintGraph (object):
         elif isinstance(priority, int):
             priority = [priority]
         for n, p in zip(node, priority):
-            self.nodes [n] = self.graph.createNode (self.subGraphId, self._(n), waypoint, p)
+            if self.deferred:
+                self.nodes [n] = self._description.addState \
+                        (self._(n), waypoint, p)
+            else:
+                self.nodes [n] = self.graph.createNode \
+                        (self.subGraphId, self._(n), waypoint, p)
 
     ### Create an edge
     ## \param nodeFrom, nodeTo the extremities of the edge,
@@ -126,7 +224,12 @@ class ConstraintGraph (object):
                     isInNode = nodeFrom
                 else:
                     isInNode = nodeTo
-        self.edges [name] = self.graph.createEdge \
+        if self.deferred:
+            self.edges [name] = self._description.addEdge \
+                            (self._(name), self.nodes[nodeFrom],
+                             self.nodes[nodeTo], weight, self.nodes[isInNode])
+        else:
+            self.edges [name] = self.graph.createEdge \
                             (self.nodes[nodeFrom], self.nodes[nodeTo],
                              self._(name), weight, self.nodes[isInNode])
         return self.edges [name]
@@ -136,6 +239,10 @@ class ConstraintGraph (object):
     #  \param node the node.
     #  Paths satisfying the edge constraints satisfy the node constraints.
     def setContainingNode (self, edge, node) :
+        if self.deferred:
+            self._description.edges [self.edges [edge]]['containingState'] = \
+                    self.nodes [node]
+            return
         return self.graph.setContainingNode (self.edges [edge],
                                              self.nodes [node])
 
@@ -155,6 +262,9 @@ class ConstraintGraph (object):
     #  configuration to extend itself is projected in the destination
     #  node. This makes the rate of success higher.
     def setShort (self, edge, isShort) :
+      if self.deferred:
+          self._description.edges [self.edges [edge]]['isShort'] = isShort
+          return
       return self.client.graph.setShort (self.edges [edge], isShort)
 
     def isShort (self, edge) :
@@ -185,9 +295,14 @@ class ConstraintGraph (object):
             n = name + "_e" + str(nb)
         else:
             n = name
-        wid = self.edges[n] = self.graph.createWaypointEdge (
-                self.nodes[nodeFrom], self.nodes[nodeTo], self._(name),
-                nb, weight, self.nodes [isInNode])
+        if self.deferred:
+            self.edges[n] = self._description.addEdge (self._(name),
+                    self.nodes[nodeFrom], self.nodes[nodeTo], weight,
+                    self.nodes [isInNode], nb)
+        else:
+            self.edges[n] = self.graph.createWaypointEdge (
+                    self.nodes[nodeFrom], self.nodes[nodeTo], self._(name),
+                    nb, weight, self.nodes [isInNode])
 
         if not automaticBuilder:
             return
@@ -198,18 +313,32 @@ class ConstraintGraph (object):
             waypoints.append((name + "_e" + str(i), name + "_n" + str(i)))
             n = waypoints[-1][1]
             e = waypoints[-1][0]
-            newN = self.nodes[n] = \
-                    self.graph.createNode (self.subGraphId, self._(n), True)
-            newE = self.edges[e] = \
-                    self.createEdge (previous, n, self._(e), -1,
-                                     isInNode)
-            self.graph.setWaypoint (wid, i, newE, newN);
+            self.createNode (n, True)
+            self.edges[e] = self.createEdge (previous, n, self._(e), -1,
+                                             isInNode)
+            self.setWaypoint (name + "_e" + str(nb), i, e, n)
             previous = n
 
+    ### Set a waypoint of a WaypointEdge.
+    ## \param edge name of the WaypointEdge,
+    ## \param index index of the waypoint,
+    ## \param waypointEdge name of the edge leading to the waypoint node,
+    ## \param waypointNode name of the waypoint node.
+    def setWaypoint (self, edge, index, waypointEdge, waypointNode):
+        if self.deferred:
+            self._description.edges [self.edges [edge]]['waypoints'][index] = \
+                    (self.edges [waypointEdge], self.nodes [waypointNode])
+            return
+        self.graph.setWaypoint (self.edges [edge], index,
+                self.edges [waypointEdge], self.nodes [waypointNode])
+
     ### Create a LevelSetEdge.
     ## \param nodeFrom, nodeTo, name, weight, isInNode see createEdge note.
     ## \note See documentation of class hpp::manipulation::graph::LevelSetEdge for more information.
     def createLevelSetEdge (self, nodeFrom, nodeTo, name, weight = 1, isInNode = None):
+        if self.deferred:
+            raise NotImplementedError \
+                    ("Level set edges cannot be created in deferred mode.")
         if isInNode is None:
             if self.nodes[nodeFrom] > self.nodes[nodeTo]:
                 isInNode = nodeFrom
@@ -369,7 +498,22 @@ class ConstraintGraph (object):
                     nopdofs.append("")
                     pdofs.append (pair.passiveJoints)
 
-        if node is not None:
+        if self.deferred:
+            if node is not None:
+                state = self._description.states [self.nodes [node]]
+                c = state ['constraints']
+                state ['pathConstraints'].extend (nc)
+                state ['pathPassiveDofs'].extend (pdofs)
+            elif edge is not None:
+                c = self._description.edges [self.edges [edge]]['constraints']
+            elif graph:
+                c = self._description.constraints
+            else:
+                return
+            c ['numerical'].extend (nc)
+            c ['passiveDofs'].extend (nopdofs)
+            c ['lockedJoints'].extend (lockDof)
+        elif node is not None:
             self.graph.addNumericalConstraints (self.nodes [node], nc, nopdofs)
             self.graph.addNumericalConstraintsForPath (self.nodes [node], nc,
                                                        pdofs)
@@ -395,6 +539,9 @@ class ConstraintGraph (object):
     def addLevelSetFoliation (self, edge,
             condGrasps = None, condPregrasps = None, condNC = [], condLJ = [],
             paramGrasps = None, paramPregrasps = None, paramNC = [], paramPassiveJoints = [], paramLJ = []):
+        if self.deferred:
+            raise NotImplementedError \
+                    ("Level set edges cannot be created in deferred mode.")
 
         cond_nc = condNC [:]
         if condGrasps is not None:
@@ -430,6 +577,13 @@ class ConstraintGraph (object):
     ## Set weight of an edge
     #
     def setWeight (self, edge, weight):
+        if self.deferred:
+            e = self._description.edges [self.edges [edge]]
+            if e ['weight'] == -1:
+                raise RuntimeError ('You cannot set weight for "' + edge +
+                                    '". Perhaps it is a waypoint edge ?')
+            e ['weight'] = weight
+            return
         if self.client.graph.getWeight (self.edges [edge]) == -1:
             raise RuntimeError ('You cannot set weight for "' + edge +
                                 '". Perhaps it is a waypoint edge ?')
@@ -497,6 +651,54 @@ class ConstraintGraph (object):
         return self.client.problem.applyConstraints (self.nodes [node],
                                                      input)
 
+    ## Apply constaints to several configurations
+    #
+    #  \param node name of the node the constraints of which to apply
+    #  \param inputs list of input configurations,
+    #  \retval outputs output configurations,
+    #  \retval success whether each projection succeeded,
+    #  \retval errors norm of the residual error of each projection.
+    #
+    #  Configurations are projected concurrently by the server.
+    def applyNodeConstraintsBatch (self, node, inputs) :
+        nbSuccess, outputs, success, errors = \
+            self.client.problem.applyConstraintsBatch (self.nodes [node],
+                                                       inputs)
+        return outputs, success, errors
+
+    ## Time the projection of configurations one by one and in a batch
+    #
+    #  \param comp name of a node or of an edge,
+    #  \param inputs list of input configurations.
+    #  \return a dictionary mapping "scalar" and "batch" to the time in
+    #          seconds and the number of successful projections.
+    #  \warning This is a diagnostic, which may change or be removed.
+    #  \sa hpp::corbaserver::manipulation::Problem::benchmarkProjection
+    def benchmarkProjection (self, comp, inputs) :
+        if comp in self.nodes: id = self.nodes [comp]
+        else: id = self.edges [comp]
+        times, nbSuccess = \
+            self.client.problem.benchmarkProjection (id, inputs)
+        return { 'scalar': (times [0], nbSuccess [0]),
+                 'batch':  (times [1], nbSuccess [1]) }
+
+    ## Sample valid configurations in a node
+    #
+    #  \param node name of the node,
+    #  \param count number of configurations to return,
+    #  \param maxAttempts maximal number of random configurations.
+    #  \retval configs the valid configurations, at most count,
+    #  \retval acceptanceRate ratio of valid configurations over the number
+    #          of random configurations,
+    #  \retval phaseTimes time spent shooting, projecting and validating.
+    #
+    #  The whole shoot, project and validate loop runs on the server.
+    def sampleNodeConfigurations (self, node, count, maxAttempts) :
+        nbAttempts, configs, acceptanceRate, phaseTimes = \
+            self.client.problem.sampleStateConfigurations \
+            (self.nodes [node], count, maxAttempts)
+        return configs, acceptanceRate, phaseTimes
+
     ## Apply edge constaints to a configuration
     #
     #  \param edge name of the edge
@@ -512,6 +714,43 @@ class ConstraintGraph (object):
         return self.client.problem.applyConstraintsWithOffset \
             (self.edges [edge], qfrom, input)
 
+    ## Generate target configurations of an edge from several sources
+    #
+    #  \param edge name of the edge
+    #  \param qfroms configurations defining the right hand side of the edge
+    #         constraint,
+    #  \param inputs input configurations, one per source.
+    #  \retval outputs output configurations,
+    #  \retval success whether each projection succeeded,
+    #  \retval errors norm of the residual error of each projection,
+    #  \retval leaves index of the leaf of each source.
+    #
+    #  Configurations are projected concurrently by the server.
+    def generateTargetConfigs (self, edge, qfroms, inputs) :
+        nbSuccess, outputs, success, errors, leaves = \
+            self.client.problem.generateTargetConfigs (self.edges [edge],
+                                                       qfroms, inputs)
+        return outputs, success, errors, leaves
+
+    ## Project a configuration onto the target of every outgoing edge of the
+    #  node of another configuration
+    #
+    #  \param q1 configuration defining the node and the right hand side of
+    #         the edge constraints,
+    #  \param q2 input configuration of each projection.
+    #  \return the name of the node of q1 and a dictionary mapping the name
+    #          of each outgoing edge to the tuple (success, output
+    #          configuration, residual error).
+    def probeOutgoingEdges (self, q1, q2) :
+        nbSuccess, node, edgeIds, outputs, success, errors = \
+            self.client.problem.probeOutgoingEdges (q1, q2)
+        nodes = dict ((id, name) for name, id in self.nodes.items ())
+        edges = dict ((id, name) for name, id in self.edges.items ())
+        res = dict ()
+        for id, q, s, e in zip (edgeIds, outputs, success, errors):
+            res [edges.get (id, id)] = (s, q, e)
+        return nodes.get (node, node), res
+
     ## Build a path from qb to qe using the Edge::build.
     #  \param edge name of the edge to use.
     #  \param qb configuration at the beginning of the path
@@ -529,6 +768,24 @@ class ConstraintGraph (object):
         return self.client.problem.buildAndProjectPath \
             (self.edges [edge], qb, qe)
 
+    ## Build and project several paths
+    #
+    #  \param edges names of the edges to use,
+    #  \param qbs, qes configurations at the beginning and at the end of
+    #         each path.
+    #  \retval success whether each path is built and fully projected,
+    #  \retval indexesNotProj, indexesProj indexes of the paths, as in
+    #          buildAndProjectPath,
+    #  \retval coverage ratio of the length of each projected path over the
+    #          length of the built path.
+    #
+    #  Paths are built concurrently by the server.
+    def buildAndProjectPaths (self, edges, qbs, qes) :
+        nbSuccess, success, indexesNotProj, indexesProj, coverage = \
+            self.client.problem.buildAndProjectPaths \
+            ([ self.edges [e] for e in edges ], qbs, qes)
+        return success, indexesNotProj, indexesProj, coverage
+
     ## Get error of a config with respect to a node constraint
     #
     #  \param node name of the node.
@@ -551,6 +808,39 @@ class ConstraintGraph (object):
             if id == nodeId: return n
         raise RuntimeError ("No node with id {0}".format (nodeId))
 
+    ## Get the statistics of the ManipulationPlanner for all the edges.
+    #  \return a dictionnary mapping each edge name to a dictionnary
+    #          mapping each failure reason to its frequency.
+    def getAllEdgeStats (self):
+        ids, reasons, freqs = self.client.graph.getAllEdgeStats ()
+        names = dict ((id, n) for n, id in self.edges.iteritems ())
+        return dict ((names.get (id, id), dict (zip (reasons, f)))
+                     for id, f in zip (ids, freqs))
+
+    ## Get the profile of the projections onto a node or an edge.
+    #  \param name name of the node or of the edge.
+    #  \return a ProjectorProfile structure.
+    #  Only the projections requested to the server, as in
+    #  applyNodeConstraints, are measured.
+    def getProjectorProfile (self, name):
+        if self.nodes.has_key (name):
+            return self.client.graph.getProjectorProfile (self.nodes [name])
+        return self.client.graph.getProjectorProfile (self.edges [name])
+
+    ##  Get the nodes corresponding to the state of several configurations.
+    #  \param configs list of configurations.
+    #  \param withErrors whether to return the error norms.
+    #  \return the list of node names, None for configurations that belong
+    #          to no node, and if withErrors is True, the list of the error
+    #          norms of the node constraints.
+    def getNodes (self, configs, withErrors = False):
+        nb, nodeIds, errors = self.client.graph.getNodes (configs, withErrors)
+        names = dict ((id, n) for n, id in self.nodes.iteritems ())
+        nodes = [ names.get (id) if id >= 0 else None for id in nodeIds ]
+        if withErrors:
+            return nodes, errors
+        return nodes
+
     ## Get error of a config with respect to a edge constraint
     #
     #  \param edge name of the edge.
@@ -76,6 +76,9 @@ class Rules(object):
 # # graph is initialized
 # \endcode
 #
+# If graph was created with \c deferred=True, the whole graph is sent to
+# the server in a single request at the end of \ref generate.
+#
 # The behaviour can be tuned by setting the callback functions:
 # - \ref constraint_graph_factory_behaviour_tuning "Behaviour tuning"
 #   - \ref graspIsAllowed (redundant with \ref setRules)
@@ -228,6 +231,8 @@ class ConstraintGraphFactory(object):
     def generate(self):
         grasps = ( None, ) * len(self.grippers)
         self._recurse(self.grippers, self.handles, grasps, 0)
+        if self.graph.deferred:
+            self.graph.submit ()
 
     ## \}
 
@@ -417,10 +422,9 @@ class ConstraintGraphFactory(object):
                 nb = "{0}_{2}{1}".format(names[1], i, i+1)
                 self.graph.createEdge (wStates[i], wStates[i+1], nf, -1)
                 self.graph.createEdge (wStates[i+1], wStates[i], nb, -1)
-                self.graph.graph.setWaypoint (self.graph.edges[transitions[0]],
-                        i, self.graph.edges[nf], self.graph.nodes[wStates[i+1]])
-                self.graph.graph.setWaypoint (self.graph.edges[transitions[1]],
-                        nTransitions - 1 - i, self.graph.edges[nb], self.graph.nodes[wStates[i]])
+                self.graph.setWaypoint (transitions[0], i, nf, wStates[i+1])
+                self.graph.setWaypoint (transitions[1], nTransitions - 1 - i,
+                        nb, wStates[i])
                 wTransitions.append ( (nf, nb) )
 
             # Set states
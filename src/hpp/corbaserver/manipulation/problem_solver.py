@@ -62,6 +62,97 @@ class ProblemSolver (object):
     def selectProblem (self, name):
         return self.client.manipulation.problem.selectProblem (name)
 
+    ## Create a problem from another one.
+    #
+    #  The new problem shares the robot and the obstacles of the source. Its
+    #  constraint graph, which must have been built by
+    #  hpp::corbaserver::manipulation::Graph::buildGraphFromDescription, and
+    #  its paths are copies.
+    #  \param source name of an existing problem,
+    #  \param target name of the new problem,
+    #  \param copyRoadmap whether to copy the roadmap of the source.
+    #  \sa hpp::corbaserver::manipulation::Problem::cloneProblem
+    def cloneProblem (self, source, target, copyRoadmap = False):
+        return self.client.manipulation.problem.cloneProblem \
+            (source, target, copyRoadmap)
+
+    ## Solve the problem with several planners concurrently.
+    #
+    #  The first solution is kept, optimized, and the other planners are
+    #  stopped.
+    #  \param nbInstances number of planners,
+    #  \param seeds seed of each planner. If given, the planners run in turns,
+    #         serially, and reseed the random generator of the server
+    #         process, so that the run is reproducible.
+    #  The other requests to the server wait until the portfolio ends.
+    #  \return the total time, the index of the solution path (-1 if none),
+    #          the index of the planner that found it, the number of
+    #          iterations and the time of each planner.
+    #  \sa hpp::corbaserver::manipulation::Problem::solvePortfolio
+    def solvePortfolio (self, nbInstances, seeds = []):
+        return self.client.manipulation.problem.solvePortfolio \
+            (nbInstances, seeds)
+
+    ## \name Jobs
+    #  Jobs are submitted with the submit* methods of
+    #  hpp::corbaserver::manipulation::Problem, for instance
+    #  \code
+    #  job = ps.client.manipulation.problem.submitInitializeGraph ()
+    #  \endcode
+    #  \{
+
+    ## State of a job
+    #  \return the state, the time since the job started and the error
+    #          message, if the job failed.
+    def getJobState (self, job):
+        return self.client.manipulation.problem.getJobState (job)
+
+    def cancelJob (self, job):
+        return self.client.manipulation.problem.cancelJob (job)
+
+    ## Wait for a job to finish and get its result.
+    #  \param period time between two polls, in seconds.
+    def waitForJob (self, job, period = 0.05):
+        from time import sleep
+        from hpp.corbaserver.manipulation import JOB_PENDING, JOB_RUNNING
+        while self.getJobState (job) [0] in (JOB_PENDING, JOB_RUNNING):
+            sleep (period)
+        return self.client.manipulation.problem.getJobResult (job)
+    ## \}
+
+    ## Get a handle on a problem, that does not depend on the selection.
+    #  If no problem with this name exists, a new
+    #  hpp::manipulation::ProblemSolver is created. The selection is
+    #  unchanged.
+    #  \param name the problem name.
+    #  \return the handle.
+    def openProblemHandle (self, name):
+        return self.client.manipulation.problem.openProblemHandle (name)
+
+    def closeProblemHandle (self, handle):
+        return self.client.manipulation.problem.closeProblemHandle (handle)
+
+    ## Get the manipulation interfaces bound to the problem of a handle.
+    #
+    #  All the requests sent to these interfaces use the problem of the
+    #  handle, whatever the selected problem.
+    #  \param handle a handle returned by openProblemHandle.
+    #  \return the Graph, Problem and Robot interfaces.
+    #  \sa hpp::corbaserver::manipulation::Problem::getProblemHandleInterfaces
+    def getProblemHandleInterfaces (self, handle):
+        return self.client.manipulation.problem.getProblemHandleInterfaces \
+            (handle)
+
+    ## Solve the problem of a handle.
+    #
+    #  Several problems can be solved concurrently, from different clients
+    #  or threads.
+    #  \param handle a handle returned by openProblemHandle.
+    #  \return the time spent in seconds and the index of the solution path
+    #          in the problem.
+    def solveProblemHandle (self, handle):
+        return self.client.manipulation.problem.solve (handle)
+
     ## Return a list of available elements of type type
     #  \param type enter "type" to know what types I know of.
     #              This is case insensitive.
@@ -662,6 +753,65 @@ class ProblemSolver (object):
     def concatenatePath (self, pathId1, pathId2):
         return self.client.basic.problem.concatenatePath (pathId1, pathId2)
 
+    ## \name Retention of the paths built along the graph edges
+    #  \{
+
+    ## Set what is done with the paths computed by
+    #  ConstraintGraph.buildAndProjectPath and
+    #  ConstraintGraph.buildAndProjectPaths.
+    #  \param retention one of hpp.corbaserver.manipulation.RETAIN_IN_PROBLEM,
+    #         RETAIN_IN_STORE, DISCARD and RETAIN_IN_PROBLEM_SHARED.
+    #  \sa hpp::corbaserver::manipulation::Problem::setPathRetention
+    def setPathRetention (self, retention):
+        return self.client.manipulation.problem.setPathRetention (retention)
+
+    def getPathRetention (self):
+        return self.client.manipulation.problem.getPathRetention ()
+
+    ## Set the bounds of the path store
+    #  \param maxPaths maximal number of paths, 0 for no limit,
+    #  \param maxBytes maximal estimated size of the paths, 0 for no limit.
+    def setPathStoreCapacity (self, maxPaths, maxBytes = 0):
+        return self.client.manipulation.problem.setPathStoreCapacity \
+            (maxPaths, maxBytes)
+
+    ## Prevent a path of the store from being removed, or allow it again.
+    def pinStoredPath (self, pathId, pin = True):
+        return self.client.manipulation.problem.pinStoredPath (pathId, pin)
+
+    ## Add a path of the store to the path vector.
+    #  \return the index of the path in the path vector.
+    def promoteStoredPath (self, pathId):
+        return self.client.manipulation.problem.promoteStoredPath (pathId)
+
+    def clearPathStore (self):
+        return self.client.manipulation.problem.clearPathStore ()
+
+    ## \return the number of paths in the store, their estimated size in
+    #          bytes, and the number of paths removed because a bound was
+    #          exceeded.
+    def getPathStoreStats (self):
+        return self.client.manipulation.problem.getPathStoreStats ()
+    ## \}
+
+    ## Enable or disable warm start of the projections onto graph components
+    #  \param enable whether projections start by moving the configuration
+    #         as the projection of the nearest previous input moved it,
+    #  \param size number of projections kept per graph component.
+    #  \sa hpp::corbaserver::manipulation::Problem::setWarmStart
+    def setWarmStart (self, enable, size = 8):
+        return self.client.manipulation.problem.setWarmStart (enable, size)
+
+    ## Statistics of the cache of right hand sides of edge constraints
+    #  \return the number of right hand sides taken from the cache, the
+    #          number of right hand sides computed and the number of leaves
+    #          in the cache.
+    def getRightHandSideCacheStats (self):
+        return self.client.manipulation.problem.getRightHandSideCacheStats ()
+
+    def clearRightHandSideCache (self):
+        return self.client.manipulation.problem.clearRightHandSideCache ()
+
 
     ## \name Interruption of a path planning request
     #  \{
@@ -356,6 +356,24 @@ class Robot (object):
     def isConfigValid (self, cfg):
         return self.client.basic.robot.isConfigValid (cfg)
 
+    ## Check the validity of several configurations.
+    #
+    # The configurations are checked concurrently by the server.
+    # \param cfgs list of configurations,
+    # \param withCollisionPairs whether to return the colliding pairs.
+    # \return the list of validities and, if withCollisionPairs is True, the
+    #         list of the first colliding pair of each configuration, None
+    #         for configurations that are not in collision.
+    def isConfigValidBatch (self, cfgs, withCollisionPairs = False):
+        nbValid, valid, objects1, objects2 = \
+            self.client.manipulation.problem.isConfigValidBatch \
+            (cfgs, withCollisionPairs)
+        if not withCollisionPairs:
+            return valid
+        pairs = [ (o1, o2) if o1 else None
+                  for o1, o2 in zip (objects1, objects2) ]
+        return valid, pairs
+
     ## Compute distances between bodies and obstacles
     #
     # \return list of distances,
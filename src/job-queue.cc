@@ -0,0 +1,219 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "job-queue.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      namespace {
+        boost::posix_time::ptime now ()
+        {
+          return boost::posix_time::microsec_clock::universal_time ();
+        }
+      }
+
+      struct JobQueue::Job
+      {
+        Job (long i, const Task_t& t) :
+          id (i), task (t), state (Pending), cancelRequested (false)
+        {}
+
+        long id;
+        Task_t task;
+        State state;
+        bool cancelRequested;
+        boost::posix_time::ptime start, end;
+        std::vector <long> result;
+        std::string error;
+      }; // struct Job
+
+      JobQueue::JobQueue (std::size_t nbThreads, std::size_t maxJobs,
+          std::size_t maxFinished) :
+        maxJobs_ (maxJobs), maxFinished_ (maxFinished), active_ (0),
+        nextId_ (0), stop_ (false)
+      {
+        if (nbThreads == 0) nbThreads = 1;
+        for (std::size_t i = 0; i < nbThreads; ++i)
+          workers_.create_thread (boost::bind (&JobQueue::work, this));
+      }
+
+      JobQueue::~JobQueue ()
+      {
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          stop_ = true;
+        }
+        condition_.notify_all ();
+        workers_.join_all ();
+      }
+
+      long JobQueue::submit (const Task_t& task)
+      {
+        long id;
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          if (active_ >= maxJobs_)
+            throw std::length_error ("Too many pending jobs.");
+          id = nextId_++;
+          JobPtr_t job (new Job (id, task));
+          jobs_[id] = job;
+          queue_.push_back (job);
+          ++active_;
+        }
+        condition_.notify_one ();
+        return id;
+      }
+
+      JobQueue::State JobQueue::state (long id, value_type& elapsed,
+          std::string& error)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        JobPtr_t job (get (id));
+        elapsed = 0;
+        if (job->state == Running)
+          elapsed = 1e-6 * (value_type) (now () - job->start)
+            .total_microseconds ();
+        else if (!job->start.is_not_a_date_time ())
+          elapsed = 1e-6 * (value_type) (job->end - job->start)
+            .total_microseconds ();
+        error = job->error;
+        return job->state;
+      }
+
+      bool JobQueue::cancel (long id)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        JobPtr_t job (get (id));
+        switch (job->state) {
+          case Pending:
+            for (std::deque <JobPtr_t>::iterator it = queue_.begin ();
+                it != queue_.end (); ++it) {
+              if (*it != job) continue;
+              queue_.erase (it);
+              break;
+            }
+            job->state = Cancelled;
+            --active_;
+            finished (id);
+            return true;
+          case Running:
+            job->cancelRequested = true;
+            return true;
+          default:
+            return false;
+        }
+      }
+
+      std::vector <long> JobQueue::result (long id)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        JobPtr_t job (get (id));
+        switch (job->state) {
+          case Pending:
+          case Running:
+            throw std::logic_error ("Job is not finished.");
+          case Done:
+            forget (id);
+            return job->result;
+          case Failed:
+            forget (id);
+            throw std::runtime_error (job->error);
+          case Cancelled:
+          default:
+            forget (id);
+            throw std::runtime_error ("Job was cancelled.");
+        }
+      }
+
+      JobQueue::JobPtr_t JobQueue::get (long id)
+      {
+        std::map <long, JobPtr_t>::const_iterator it = jobs_.find (id);
+        if (it == jobs_.end ())
+          throw std::invalid_argument ("No such job.");
+        return it->second;
+      }
+
+      void JobQueue::forget (long id)
+      {
+        jobs_.erase (id);
+        std::deque <long>::iterator it =
+          std::find (finished_.begin (), finished_.end (), id);
+        if (it != finished_.end ()) finished_.erase (it);
+      }
+
+      void JobQueue::finished (long id)
+      {
+        finished_.push_back (id);
+        while (finished_.size () > maxFinished_) {
+          jobs_.erase (finished_.front ());
+          finished_.pop_front ();
+        }
+      }
+
+      void JobQueue::work ()
+      {
+        while (true) {
+          JobPtr_t job;
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            while (!stop_ && queue_.empty ()) condition_.wait (lock);
+            if (stop_) return;
+            job = queue_.front ();
+            queue_.pop_front ();
+            job->state = Running;
+            job->start = now ();
+          }
+
+          std::vector <long> result;
+          std::string error;
+          bool failed = false;
+          try {
+            job->task (result);
+          } catch (const std::exception& e) {
+            failed = true;
+            error = e.what ();
+          } catch (...) {
+            failed = true;
+            error = "Unknown exception in job.";
+          }
+
+          boost::mutex::scoped_lock lock (mutex_);
+          job->end = now ();
+          job->task.clear ();
+          --active_;
+          if (job->cancelRequested) {
+            job->state = Cancelled;
+          } else if (failed) {
+            job->state = Failed;
+            job->error = error;
+          } else {
+            job->state = Done;
+            job->result.swap (result);
+          }
+          finished (job->id);
+        }
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,117 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_JOB_QUEUE_HH
+# define HPP_MANIPULATION_CORBA_JOB_QUEUE_HH
+
+# include <deque>
+# include <map>
+# include <string>
+# include <vector>
+
+# include <boost/function.hpp>
+# include <boost/shared_ptr.hpp>
+# include <boost/thread/thread.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/thread/condition_variable.hpp>
+
+# include <hpp/manipulation/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Long running requests executed in the background.
+      ///
+      /// Jobs are run in submission order by a fixed number of threads. At
+      /// most maxJobs jobs can be pending or running at the same time.
+      /// Finished jobs are kept until their result is taken, or until more
+      /// than maxFinished jobs are finished, in which case the jobs that
+      /// finished first are forgotten.
+      class JobQueue
+      {
+        public:
+          enum State {
+            Pending,
+            Running,
+            Done,
+            Failed,
+            Cancelled
+          };
+
+          /// Function running a job and filling its result.
+          typedef boost::function <void (std::vector <long>&)> Task_t;
+
+          JobQueue (std::size_t nbThreads = 2, std::size_t maxJobs = 64,
+              std::size_t maxFinished = 256);
+
+          /// Wait for the running jobs. Pending jobs are dropped.
+          ~JobQueue ();
+
+          /// \return the job ID.
+          /// \throw std::length_error if maxJobs jobs are pending or running.
+          long submit (const Task_t& task);
+
+          /// \param elapsed time since the job started, in seconds. 0 if
+          ///        it is pending.
+          /// \param error message of the exception thrown by a failed job.
+          /// \throw std::invalid_argument if the job does not exist.
+          State state (long id, value_type& elapsed, std::string& error);
+
+          /// Cancel a job.
+          ///
+          /// A pending job is not run. A running job cannot be interrupted:
+          /// it is marked as cancelled when it ends and its result is
+          /// dropped.
+          /// \return false if the job was already finished.
+          bool cancel (long id);
+
+          /// Get the result of a finished job and forget the job.
+          /// \throw std::logic_error if the job is not finished,
+          ///        std::runtime_error if it failed or was cancelled.
+          std::vector <long> result (long id);
+
+        private:
+          struct Job;
+          typedef boost::shared_ptr <Job> JobPtr_t;
+
+          /// \note mutex_ must be locked.
+          JobPtr_t get (long id);
+          /// Forget a job whose result was taken.
+          /// \note mutex_ must be locked.
+          void forget (long id);
+          /// Record that a job finished and forget the oldest finished
+          /// jobs beyond maxFinished_.
+          /// \note mutex_ must be locked.
+          void finished (long id);
+          void work ();
+
+          std::size_t maxJobs_, maxFinished_, active_;
+          long nextId_;
+          std::map <long, JobPtr_t> jobs_;
+          std::deque <JobPtr_t> queue_;
+          /// IDs of the finished jobs, in the order they finished.
+          std::deque <long> finished_;
+          boost::thread_group workers_;
+          boost::mutex mutex_;
+          boost::condition_variable condition_;
+          bool stop_;
+      }; // class JobQueue
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_JOB_QUEUE_HH
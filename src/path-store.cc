@@ -0,0 +1,137 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "path-store.hh"
+
+#include <stdexcept>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/path.hh>
+#include <hpp/core/path-vector.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      PathStore::PathStore (std::size_t maxPaths, std::size_t maxBytes) :
+        next_ (0), bytes_ (0), maxPaths_ (maxPaths), maxBytes_ (maxBytes),
+        evicted_ (0)
+      {}
+
+      PathStore::Id_t PathStore::add (const core::PathVectorPtr_t& path)
+      {
+        std::size_t size = bytes (path);
+        boost::mutex::scoped_lock lock (mutex_);
+        if (maxBytes_ > 0 && size > maxBytes_)
+          throw std::invalid_argument ("The path is larger than the path "
+              "store capacity.");
+        Id_t id = next_++;
+        Entry& e = entries_[id];
+        e.path = path;
+        e.bytes = size;
+        e.pinned = false;
+        e.use = lru_.insert (lru_.begin (), id);
+        bytes_ += e.bytes;
+        evict (id);
+        return id;
+      }
+
+      core::PathVectorPtr_t PathStore::get (Id_t id)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        Entries_t::iterator it = entries_.find (id);
+        if (it == entries_.end ()) return core::PathVectorPtr_t ();
+        lru_.splice (lru_.begin (), lru_, it->second.use);
+        return it->second.path;
+      }
+
+      void PathStore::pin (Id_t id, bool pinned)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        Entries_t::iterator it = entries_.find (id);
+        if (it == entries_.end ())
+          throw std::invalid_argument ("No path with this id in the store.");
+        it->second.pinned = pinned;
+        if (!pinned) evict ();
+      }
+
+      void PathStore::capacity (std::size_t maxPaths, std::size_t maxBytes)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        maxPaths_ = maxPaths;
+        maxBytes_ = maxBytes;
+        evict ();
+      }
+
+      void PathStore::clear ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        entries_.clear ();
+        lru_.clear ();
+        bytes_ = 0;
+      }
+
+      std::size_t PathStore::size ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return entries_.size ();
+      }
+
+      std::size_t PathStore::bytes ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return bytes_;
+      }
+
+      std::size_t PathStore::evicted ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return evicted_;
+      }
+
+      std::size_t PathStore::bytes (const core::PathPtr_t& path)
+      {
+        core::PathVectorPtr_t pv = HPP_DYNAMIC_PTR_CAST
+          (core::PathVector, path);
+        if (!pv)
+          // A path stores at least its initial and end configurations.
+          return sizeof (core::Path) + 2 * (std::size_t) path->outputSize ()
+            * sizeof (core::value_type);
+        std::size_t res = sizeof (core::PathVector);
+        for (std::size_t i = 0; i < pv->numberPaths (); ++i)
+          res += bytes (pv->pathAtRank (i));
+        return res;
+      }
+
+      void PathStore::evict (Id_t keep)
+      {
+        Lru_t::iterator it = lru_.end ();
+        while (it != lru_.begin ()
+            && ((maxPaths_ > 0 && entries_.size () > maxPaths_)
+              || (maxBytes_ > 0 && bytes_ > maxBytes_))) {
+          --it;
+          Entries_t::iterator e = entries_.find (*it);
+          if (e->second.pinned || *it == keep) continue;
+          bytes_ -= e->second.bytes;
+          entries_.erase (e);
+          it = lru_.erase (it);
+          ++evicted_;
+        }
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,103 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_PATH_STORE_HH
+# define HPP_MANIPULATION_CORBA_PATH_STORE_HH
+
+# include <list>
+# include <map>
+
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/core/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Paths kept by the server outside of the ProblemSolver.
+      ///
+      /// The store is bounded by a number of paths and an estimate of their
+      /// memory footprint. When a bound is exceeded, the least recently used
+      /// paths which are not pinned are removed.
+      class PathStore
+      {
+        public:
+          typedef long Id_t;
+
+          /// \param maxPaths maximal number of paths, 0 for no limit,
+          /// \param maxBytes maximal estimated size of the paths, 0 for no
+          ///        limit.
+          PathStore (std::size_t maxPaths = 1000, std::size_t maxBytes = 0);
+
+          /// Add a path.
+          /// The paths are removed to satisfy the bounds, except this one.
+          /// \return its identifier, never reused.
+          /// \throw std::invalid_argument if the path alone is larger than
+          ///        the maximal size.
+          Id_t add (const core::PathVectorPtr_t& path);
+
+          /// Get a path and mark it as recently used.
+          /// \return a null pointer if the path has been removed.
+          core::PathVectorPtr_t get (Id_t id);
+
+          /// A pinned path is never removed.
+          /// \throw std::invalid_argument if the path has been removed.
+          void pin (Id_t id, bool pinned);
+
+          /// Set the bounds and remove paths if needed.
+          void capacity (std::size_t maxPaths, std::size_t maxBytes);
+
+          /// Remove all the paths.
+          void clear ();
+
+          std::size_t size ();
+          /// Estimated size of the stored paths, in bytes.
+          std::size_t bytes ();
+          /// Number of paths removed because a bound was exceeded.
+          std::size_t evicted ();
+
+          /// Estimated size of a path, in bytes.
+          static std::size_t bytes (const core::PathPtr_t& path);
+
+        private:
+          typedef std::list <Id_t> Lru_t;
+          struct Entry {
+            core::PathVectorPtr_t path;
+            std::size_t bytes;
+            bool pinned;
+            /// Position in lru_.
+            Lru_t::iterator use;
+          };
+          typedef std::map <Id_t, Entry> Entries_t;
+
+          /// Remove paths until the bounds are satisfied.
+          /// \param keep a path that must not be removed.
+          /// \note mutex_ must be locked.
+          void evict (Id_t keep = -1);
+
+          Entries_t entries_;
+          /// Identifiers, from the most to the least recently used.
+          Lru_t lru_;
+          Id_t next_;
+          std::size_t bytes_, maxPaths_, maxBytes_, evicted_;
+          boost::mutex mutex_;
+      }; // class PathStore
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_PATH_STORE_HH
@@ -0,0 +1,215 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "problem-locks.hh"
+
+#include <stdexcept>
+
+#include <hpp/manipulation/problem-solver.hh>
+#include <hpp/corbaserver/manipulation/server.hh>
+
+#include "hpp/corbaserver/manipulation/gcommon.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      ProblemLocks::Bind::Bind (Server* server, const std::string& name) :
+        locks_ (server->problemLocks ())
+      {
+        if (locks_.held_.get () != NULL)
+          throw std::logic_error ("Cannot bind a thread holding a lock.");
+        Binding* binding = new Binding;
+        binding->name = name;
+        locks_.bound_.reset (binding);
+      }
+
+      ProblemLocks::Bind::~Bind ()
+      {
+        locks_.bound_.reset ();
+      }
+
+      ProblemLocks::Lock::Lock (Server* server, Mode mode,
+          const std::string& problem) :
+        locks_ (server->problemLocks ()), mode_ (mode), owner_ (false),
+        binder_ (false)
+      {
+        try {
+          acquire (server, problem);
+        } catch (const std::logic_error& exc) {
+          // The operations take the lock before converting the standard
+          // exceptions, and may only raise hpp::Error.
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      void ProblemLocks::Lock::acquire (Server* server,
+          const std::string& problem)
+      {
+        Binding* binding = locks_.bound_.get ();
+        if (binding != NULL && !problem.empty ()
+            && binding->name != problem)
+          throw std::logic_error ("Cannot use problem " + problem
+              + " from a thread bound to problem " + binding->name + ".");
+        if (const Mode* held = locks_.held_.get ()) {
+          if (*held < mode_ || (mode_ == Exclusive && *held != Exclusive))
+            throw std::logic_error ("Cannot upgrade the lock of the "
+                "problem solver held by this thread.");
+          if (binding == NULL && !problem.empty ())
+            throw std::logic_error ("Cannot use problem " + problem
+                + " while changing the selection.");
+          return;
+        }
+        if ((binding != NULL || !problem.empty ()) && mode_ >= Select)
+          throw std::logic_error ("Cannot change the selection from a "
+              "problem handle.");
+
+        if (mode_ == Exclusive) locks_.exclusive_.lock ();
+        else                    locks_.exclusive_.lock_shared ();
+        try {
+          lockProblem (server, problem);
+        } catch (...) {
+          if (mode_ == Exclusive) locks_.exclusive_.unlock ();
+          else                    locks_.exclusive_.unlock_shared ();
+          throw;
+        }
+        locks_.held_.reset (new Mode (mode_));
+        owner_ = true;
+      }
+
+      void ProblemLocks::Lock::lockProblem (Server* server,
+          const std::string& problem)
+      {
+        Binding* binding = locks_.bound_.get ();
+        corbaServer::ProblemSolverMapPtr_t psMap (server->problemSolverMap ());
+        switch (mode_) {
+          case Select:
+            locks_.selection_.lock ();
+            break;
+          case Replace:
+            for (;;) {
+              locks_.selection_.lock_shared ();
+              std::string name (psMap->selected_);
+              locks_.selection_.unlock_shared ();
+              problem_ = locks_.problem (name);
+              problem_->lock ();
+              locks_.selection_.lock ();
+              if (psMap->selected_ == name
+                  && locks_.problem (name) == problem_) break;
+              // Another problem was selected, or the problem solver was
+              // replaced, while waiting.
+              locks_.selection_.unlock ();
+              problem_->unlock ();
+            }
+            break;
+          case Read:
+          case Write:
+          case Exclusive: {
+            std::string name (problem);
+            if (binding != NULL) name = binding->name;
+            else if (name.empty ()) {
+              locks_.selection_.lock_shared ();
+              name = psMap->selected_;
+              locks_.selection_.unlock_shared ();
+            }
+            ProblemSolverPtr_t ps = NULL;
+            for (;;) {
+              problem_ = locks_.problem (name);
+              if (mode_ == Read) problem_->lock_shared ();
+              else               problem_->lock ();
+
+              // The problem solver cannot be replaced while it is locked,
+              // but it may have been replaced, or made to share the lock of
+              // another one, while waiting.
+              bool same;
+              ps = NULL;
+              locks_.selection_.lock_shared ();
+              if (psMap->has (name))
+                ps = dynamic_cast <ProblemSolverPtr_t> (psMap->map_[name]);
+              same = (locks_.problem (name) == problem_);
+              locks_.selection_.unlock_shared ();
+              if (ps != NULL && same) break;
+              if (mode_ == Read) problem_->unlock_shared ();
+              else               problem_->unlock ();
+              if (ps == NULL)
+                throw std::logic_error ("No manipulation problem named "
+                    + name + ".");
+            }
+            if (binding == NULL) {
+              binding = new Binding;
+              binding->name = name;
+              locks_.bound_.reset (binding);
+              binder_ = true;
+            }
+            binding->problemSolver = ps;
+            break;
+          }
+        }
+      }
+
+      ProblemLocks::Lock::~Lock ()
+      {
+        if (!owner_) return;
+        locks_.held_.reset ();
+        if (binder_)
+          locks_.bound_.reset ();
+        else if (Binding* binding = locks_.bound_.get ())
+          binding->problemSolver = NULL;
+        switch (mode_) {
+          case Replace:
+            locks_.selection_.unlock ();
+            problem_->unlock ();
+            break;
+          case Select:
+            locks_.selection_.unlock ();
+            break;
+          case Write:
+          case Exclusive:
+            problem_->unlock ();
+            break;
+          case Read:
+            problem_->unlock_shared ();
+            break;
+        }
+        if (mode_ == Exclusive) locks_.exclusive_.unlock ();
+        else                    locks_.exclusive_.unlock_shared ();
+      }
+
+      void ProblemLocks::share (const std::string& name,
+          const std::string& source)
+      {
+        SharedMutexPtr_t m = problem (source);
+        boost::mutex::scoped_lock lock (mutex_);
+        problems_[name] = m;
+      }
+
+      void ProblemLocks::erase (const std::string& name)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        problems_.erase (name);
+      }
+
+      ProblemLocks::SharedMutexPtr_t ProblemLocks::problem
+      (const std::string& name)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        SharedMutexPtr_t& m = problems_[name];
+        if (!m) m.reset (new boost::shared_mutex ());
+        return m;
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
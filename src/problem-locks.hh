@@ -0,0 +1,164 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_PROBLEM_LOCKS_HH
+# define HPP_MANIPULATION_CORBA_PROBLEM_LOCKS_HH
+
+# include <map>
+# include <string>
+
+# include <boost/noncopyable.hpp>
+# include <boost/shared_ptr.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/thread/shared_mutex.hpp>
+# include <boost/thread/tss.hpp>
+
+# include <hpp/corbaserver/manipulation/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Reader/writer locks protecting the problem solvers from the
+      /// requests that omniORB dispatches concurrently.
+      ///
+      /// Each request locks the problem solver it uses, in shared mode if it
+      /// only reads it, or in exclusive mode otherwise. The problem solver
+      /// is the one the thread is bound to (see Bind), the one given to the
+      /// lock, or else the selected one. Its name is read under the lock of
+      /// the selection, which is released before waiting for the problem
+      /// solver: a long request on a problem solver never prevents the
+      /// other clients from selecting or using other problems. The thread is
+      /// then bound to the problem solver until the lock is released, so
+      /// that Server::problemSolver returns it even if the selection
+      /// changes.
+      ///
+      /// Changing the map of problem solvers or the selection locks the
+      /// selection in exclusive mode. Replacing the selected problem solver
+      /// also waits for the requests that use it. An Exclusive lock waits
+      /// for all the requests, whatever their problem solver.
+      class ProblemLocks
+      {
+        public:
+          enum Mode {
+            /// The request does not modify the problem solver.
+            Read,
+            /// The request may modify the problem solver.
+            Write,
+            /// The request may modify the problem solver, and no other
+            /// request may run meanwhile, because it uses the state of the
+            /// process, like the random generator.
+            Exclusive,
+            /// The request changes the map of problem solvers or the
+            /// selection.
+            Select,
+            /// The request replaces the selected problem solver.
+            Replace
+          };
+
+          /// Problem solver used by the requests of a thread.
+          struct Binding
+          {
+            std::string name;
+            /// Set when the problem solver is locked.
+            ProblemSolverPtr_t problemSolver;
+          }; // struct Binding
+
+          /// Bind the requests of the current thread to a problem solver,
+          /// until destruction.
+          class Bind : boost::noncopyable
+          {
+            public:
+              /// \throw std::logic_error if the thread holds a lock.
+              Bind (Server* server, const std::string& name);
+              ~Bind ();
+
+            private:
+              ProblemLocks& locks_;
+          }; // class Bind
+
+          /// Lock held by a request until it returns.
+          ///
+          /// A thread that already holds a lock does not lock again, so
+          /// that operations may call each other. The outer lock must then
+          /// be at least as strong as the inner one, and on the same problem
+          /// solver.
+          class Lock : boost::noncopyable
+          {
+            public:
+              /// \param problem name of the problem solver to use instead of
+              ///        the selected one, if not empty.
+              /// \throw hpp::Error if the thread holds a weaker lock, or
+              ///        changes the selection while bound, or if the problem
+              ///        solver does not exist.
+              Lock (Server* server, Mode mode,
+                  const std::string& problem = std::string ());
+              ~Lock ();
+
+            private:
+              /// \throw std::logic_error if the lock cannot be taken.
+              void acquire (Server* server, const std::string& problem);
+              /// Lock the selection or the problem solver, as required by
+              /// the mode.
+              /// \throw std::logic_error if the problem solver does not
+              ///        exist.
+              void lockProblem (Server* server, const std::string& problem);
+
+              ProblemLocks& locks_;
+              Mode mode_;
+              /// Whether the lock bound the thread.
+              bool owner_, binder_;
+              boost::shared_ptr <boost::shared_mutex> problem_;
+          }; // class Lock
+
+          /// Binding of the current thread, or NULL.
+          const Binding* bound ()
+          {
+            return bound_.get ();
+          }
+
+          /// Make a problem solver use the lock of another one, because
+          /// the requests on one of them modify objects of the other, like
+          /// the robot.
+          /// \note The selection must be locked in exclusive mode.
+          void share (const std::string& name, const std::string& source);
+
+          /// Forget the lock of a problem solver, when it is created or
+          /// replaced. The requests waiting for the former lock take the
+          /// new one.
+          /// \note The selection must be locked in exclusive mode.
+          void erase (const std::string& name);
+
+        private:
+          typedef boost::shared_ptr <boost::shared_mutex> SharedMutexPtr_t;
+
+          /// Get the lock of a problem solver, creating it if needed.
+          SharedMutexPtr_t problem (const std::string& name);
+
+          /// Locked in shared mode by all the locks but the Exclusive ones.
+          boost::shared_mutex exclusive_;
+          boost::shared_mutex selection_;
+          std::map <std::string, SharedMutexPtr_t> problems_;
+          boost::mutex mutex_;
+          /// Mode of the lock held by the current thread, if any.
+          boost::thread_specific_ptr <Mode> held_;
+          boost::thread_specific_ptr <Binding> bound_;
+      }; // class ProblemLocks
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_PROBLEM_LOCKS_HH
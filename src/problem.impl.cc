@@ -19,16 +19,28 @@
 
 #include <hpp/corbaserver/manipulation/server.hh>
 
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <hpp/util/debug.hh>
 #include <hpp/core/roadmap.hh>
+#include <hpp/core/node.hh>
+#include <hpp/core/edge.hh>
 #include <hpp/core/distance.hh>
 #include <hpp/core/comparison-type.hh>
 #include <hpp/core/config-projector.hh>
 #include <hpp/core/path-projector.hh>
 #include <hpp/core/path-vector.hh>
+#include <hpp/core/steering-method.hh>
+#include <hpp/core/configuration-shooter.hh>
+#include <hpp/core/config-validations.hh>
+#include <hpp/core/collision-validation-report.hh>
+#include <hpp/pinocchio/collision-object.hh>
 #include <hpp/pinocchio/gripper.hh>
 #include <hpp/constraints/convex-shape-contact.hh>
 #ifdef HPP_CONSTRAINTS_USE_QPOASES
@@ -44,6 +56,13 @@
 #include <hpp/manipulation/graph-steering-method.hh>
 
 #include "tools.hh"
+#include "thread-pool.hh"
+#include "roadmap-index.hh"
+#include "projection-profiler.hh"
+#include "problem-locks.hh"
+#include "graph.impl.hh"
+#include "robot.impl.hh"
+#include "job-queue.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -99,10 +118,741 @@ namespace hpp {
           }
           return jointNames;
         }
+
+        /// Project q onto the constraints of component id, starting from
+        /// a seed given by the previous projections if warm start is
+        /// enabled. If this fails, or if the solution found from the seed
+        /// is too far from q, q is projected from its initial value.
+        /// \param seeds the store of the previous projections,
+        /// \param store where the projection is stored if it succeeds, or
+        ///        NULL.
+        bool project (const ConstraintSetPtr_t& c, WarmStartStore& seeds,
+            WarmStartStore* store, const graph::GraphPtr_t& graph,
+            std::size_t id, Configuration_t& q, value_type& residual,
+            ProjectionProfiler::Profile& profile)
+        {
+          core::ConfigProjectorPtr_t cp = c->configProjector ();
+          Stopwatch watch;
+          Configuration_t input (q);
+          value_type maxDistance;
+          bool warm = seeds.seed (graph, id, cp, q, maxDistance);
+          bool success = c->apply (q);
+          // The output must remain a projection of the input, not of a
+          // previous one.
+          if (warm && success && (q - input).norm () > maxDistance)
+            success = false;
+          bool warmSuccess = warm && success;
+          if (warm && !success) {
+            q = input;
+            success = c->apply (q);
+          }
+          residual = (cp ? cp->residualError () : 0);
+          if (success && store) store->add (graph, id, cp, input, q);
+          value_type time = watch.elapsed ();
+          profile.add (time, success, residual);
+          if (warm) profile.addWarmStart (time, warmSuccess);
+          return success;
+        }
+
+        /// Project configurations, with one copy of the constraints per
+        /// thread. The projections are seeded from warmStart, but not
+        /// stored in it.
+        struct ApplyConstraints
+        {
+          ApplyConstraints (const ConstraintSetPtr_t& constraint,
+              WarmStartStore& warmStart, const graph::GraphPtr_t& graph,
+              std::size_t id, std::vector <ConstraintSetPtr_t>& copies,
+              std::vector <Configuration_t>& qs, std::vector <char>& success,
+              vector_t& residuals,
+              std::vector <ProjectionProfiler::Profile>& profiles) :
+            constraint_ (constraint), warmStart_ (warmStart), graph_ (graph),
+            id_ (id), copies_ (copies), qs_ (qs), success_ (success),
+            residuals_ (residuals), profiles_ (profiles)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            ConstraintSetPtr_t& c = copies_[thread];
+            if (!c) c = copyConstraintSet (constraint_);
+            success_[i] = project (c, warmStart_, NULL, graph_, id_, qs_[i],
+                residuals_[i], profiles_[thread]);
+          }
+
+          const ConstraintSetPtr_t& constraint_;
+          WarmStartStore& warmStart_;
+          const graph::GraphPtr_t& graph_;
+          std::size_t id_;
+          std::vector <ConstraintSetPtr_t>& copies_;
+          std::vector <Configuration_t>& qs_;
+          std::vector <char>& success_;
+          vector_t& residuals_;
+          std::vector <ProjectionProfiler::Profile>& profiles_;
+        }; // struct ApplyConstraints
+
+        /// Project configurations and validate those that could be
+        /// projected, with one copy of the constraints per thread.
+        struct SampleConfigurations
+        {
+          SampleConfigurations (const ConstraintSetPtr_t& constraint,
+              const core::ConfigValidationsPtr_t& validations,
+              std::vector <ConstraintSetPtr_t>& copies,
+              std::vector <Configuration_t>& qs, std::vector <char>& valid,
+              std::vector <ProjectionProfiler::Profile>& profiles,
+              vector_t& validationTimes) :
+            constraint_ (constraint), validations_ (validations),
+            copies_ (copies), qs_ (qs), valid_ (valid), profiles_ (profiles),
+            validationTimes_ (validationTimes)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            ConstraintSetPtr_t& c = copies_[thread];
+            if (!c) c = copyConstraintSet (constraint_);
+            Stopwatch projection;
+            bool success = c->apply (qs_[i]);
+            value_type residual = 0;
+            if (core::ConfigProjectorPtr_t cp = c->configProjector ())
+              residual = cp->residualError ();
+            profiles_[thread].add (projection.elapsed (), success, residual);
+            if (!success) return;
+
+            Stopwatch validation;
+            core::ValidationReportPtr_t report;
+            valid_[i] = validations_->validate (qs_[i], report);
+            validationTimes_[thread] += validation.elapsed ();
+          }
+
+          const ConstraintSetPtr_t& constraint_;
+          const core::ConfigValidationsPtr_t& validations_;
+          std::vector <ConstraintSetPtr_t>& copies_;
+          std::vector <Configuration_t>& qs_;
+          std::vector <char>& valid_;
+          std::vector <ProjectionProfiler::Profile>& profiles_;
+          vector_t& validationTimes_;
+        }; // struct SampleConfigurations
+
+        /// Validate configurations, the robot holding one set of kinematic
+        /// and collision data per thread.
+        struct ValidateConfigurations
+        {
+          ValidateConfigurations (
+              const core::ConfigValidationsPtr_t& validations,
+              const std::vector <Configuration_t>& qs,
+              std::vector <char>& valid, bool withCollisionPairs,
+              std::vector <std::string>& objects1,
+              std::vector <std::string>& objects2) :
+            validations_ (validations), qs_ (qs), valid_ (valid),
+            withCollisionPairs_ (withCollisionPairs), objects1_ (objects1),
+            objects2_ (objects2)
+          {}
+
+          void operator() (std::size_t i, std::size_t) const
+          {
+            core::ValidationReportPtr_t report;
+            valid_[i] = validations_->validate (qs_[i], report);
+            if (valid_[i] || !withCollisionPairs_) return;
+            core::CollisionValidationReportPtr_t collision =
+              HPP_DYNAMIC_PTR_CAST (core::CollisionValidationReport, report);
+            if (collision) {
+              objects1_[i] = collision->object1->name ();
+              objects2_[i] = collision->object2->name ();
+            }
+          }
+
+          const core::ConfigValidationsPtr_t& validations_;
+          const std::vector <Configuration_t>& qs_;
+          std::vector <char>& valid_;
+          bool withCollisionPairs_;
+          std::vector <std::string>& objects1_;
+          std::vector <std::string>& objects2_;
+        }; // struct ValidateConfigurations
+
+        /// Compute the right hand side of the target constraint of an edge
+        /// for several sources, with one copy of the constraints per thread.
+        struct ComputeRightHandSides
+        {
+          ComputeRightHandSides (const ConstraintSetPtr_t& constraint,
+              std::vector <ConstraintSetPtr_t>& copies,
+              const std::vector <Configuration_t>& sources,
+              std::vector <vector_t>& rhs) :
+            constraint_ (constraint), copies_ (copies), sources_ (sources),
+            rhs_ (rhs)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            ConstraintSetPtr_t& c = copies_[thread];
+            if (!c) c = copyConstraintSet (constraint_);
+            if (core::ConfigProjectorPtr_t cp = c->configProjector ()) {
+              cp->rightHandSideFromConfig (sources_[i]);
+              rhs_[i] = cp->rightHandSide ();
+            }
+          }
+
+          const ConstraintSetPtr_t& constraint_;
+          std::vector <ConstraintSetPtr_t>& copies_;
+          const std::vector <Configuration_t>& sources_;
+          std::vector <vector_t>& rhs_;
+        }; // struct ComputeRightHandSides
+
+        /// Project configurations with the right hand side of their leaf,
+        /// with one copy of the constraints per thread.
+        struct GenerateTargets
+        {
+          GenerateTargets (const ConstraintSetPtr_t& constraint,
+              std::vector <ConstraintSetPtr_t>& copies,
+              const std::vector <vector_t>& rhs,
+              const std::vector <Long>& leaves,
+              std::vector <Configuration_t>& qs, std::vector <char>& success,
+              vector_t& residuals,
+              std::vector <ProjectionProfiler::Profile>& profiles) :
+            constraint_ (constraint), copies_ (copies), rhs_ (rhs),
+            leaves_ (leaves), qs_ (qs), success_ (success),
+            residuals_ (residuals), profiles_ (profiles)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            ConstraintSetPtr_t& c = copies_[thread];
+            if (!c) c = copyConstraintSet (constraint_);
+            core::ConfigProjectorPtr_t cp = c->configProjector ();
+            if (cp) cp->rightHandSide (rhs_[leaves_[i]]);
+            Stopwatch watch;
+            success_[i] = c->apply (qs_[i]);
+            if (cp) residuals_[i] = cp->residualError ();
+            profiles_[thread].add (watch.elapsed (), success_[i],
+                residuals_[i]);
+          }
+
+          const ConstraintSetPtr_t& constraint_;
+          std::vector <ConstraintSetPtr_t>& copies_;
+          const std::vector <vector_t>& rhs_;
+          const std::vector <Long>& leaves_;
+          std::vector <Configuration_t>& qs_;
+          std::vector <char>& success_;
+          vector_t& residuals_;
+          std::vector <ProjectionProfiler::Profile>& profiles_;
+        }; // struct GenerateTargets
+
+        /// Project a configuration onto the target of several edges, from
+        /// the same source, with one copy of the constraints per edge.
+        /// Waypoint and level set edges are skipped.
+        struct ProbeEdges
+        {
+          /// \param constraints the constraints of the edges, NULL for the
+          ///        edges to skip. The edges build them lazily, so they are
+          ///        fetched before the threads start.
+          ProbeEdges (const graph::Edges_t& edges,
+              const std::vector <ConstraintSetPtr_t>& constraints,
+              const Configuration_t& q1,
+              std::vector <Configuration_t>& qs, std::vector <char>& success,
+              vector_t& residuals,
+              std::vector <ProjectionProfiler::Profile>& profiles) :
+            edges_ (edges), constraints_ (constraints), q1_ (q1), qs_ (qs),
+            success_ (success), residuals_ (residuals), profiles_ (profiles)
+          {}
+
+          void operator() (std::size_t i, std::size_t) const
+          {
+            if (!constraints_[i]) return;
+            ConstraintSetPtr_t c = copyConstraintSet (constraints_[i]);
+            core::ConfigProjectorPtr_t cp = c->configProjector ();
+            Stopwatch watch;
+            if (cp) cp->rightHandSideFromConfig (q1_);
+            if (edges_[i]->isShort ()) qs_[i] = q1_;
+            success_[i] = c->apply (qs_[i]);
+            if (cp) residuals_[i] = cp->residualError ();
+            profiles_[i].add (watch.elapsed (), success_[i], residuals_[i]);
+          }
+
+          const graph::Edges_t& edges_;
+          const std::vector <ConstraintSetPtr_t>& constraints_;
+          const Configuration_t& q1_;
+          std::vector <Configuration_t>& qs_;
+          std::vector <char>& success_;
+          vector_t& residuals_;
+          std::vector <ProjectionProfiler::Profile>& profiles_;
+        }; // struct ProbeEdges
+
+        /// Build paths along edges with graph::Edge::build. The paths of an
+        /// edge are built by a single thread, since the edge sets the right
+        /// hand side of its path constraints.
+        struct BuildPaths
+        {
+          BuildPaths (const std::vector <graph::EdgePtr_t>& edges,
+              const std::vector <std::vector <std::size_t> >& groups,
+              const std::vector <Configuration_t>& qbs,
+              const std::vector <Configuration_t>& qes,
+              std::vector <core::PathPtr_t>& paths) :
+            edges_ (edges), groups_ (groups), qbs_ (qbs), qes_ (qes),
+            paths_ (paths)
+          {}
+
+          void operator() (std::size_t group, std::size_t) const
+          {
+            const std::vector <std::size_t>& g (groups_[group]);
+            for (std::size_t j = 0; j < g.size (); ++j) {
+              std::size_t i = g[j];
+              if (!edges_[i]->build (paths_[i], qbs_[i], qes_[i]))
+                paths_[i].reset ();
+            }
+          }
+
+          const std::vector <graph::EdgePtr_t>& edges_;
+          const std::vector <std::vector <std::size_t> >& groups_;
+          const std::vector <Configuration_t>& qbs_;
+          const std::vector <Configuration_t>& qes_;
+          std::vector <core::PathPtr_t>& paths_;
+        }; // struct BuildPaths
+
+        /// Project paths, with one path projector per thread.
+        struct ProjectPaths
+        {
+          ProjectPaths (const std::vector <PathProjectorPtr_t>& projectors,
+              const std::vector <core::PathPtr_t>& paths,
+              std::vector <core::PathPtr_t>& projected,
+              std::vector <char>& success) :
+            projectors_ (projectors), paths_ (paths), projected_ (projected),
+            success_ (success)
+          {}
+
+          void operator() (std::size_t i, std::size_t thread) const
+          {
+            if (!paths_[i]) return;
+            success_[i] = projectors_[thread]->apply (paths_[i],
+                projected_[i]);
+          }
+
+          const std::vector <PathProjectorPtr_t>& projectors_;
+          const std::vector <core::PathPtr_t>& paths_;
+          std::vector <core::PathPtr_t>& projected_;
+          std::vector <char>& success_;
+        }; // struct ProjectPaths
+
+        core::PathVectorPtr_t asPathVector (const core::PathPtr_t& path)
+        {
+          core::PathVectorPtr_t pv = HPP_DYNAMIC_PTR_CAST
+            (core::PathVector, path);
+          if (!pv) {
+            pv = core::PathVector::create (path->outputSize (),
+                path->outputDerivativeSize ());
+            pv->appendPath (path);
+          }
+          return pv;
+        }
+
+        /// Outcome of the planners of a portfolio.
+        struct Race
+        {
+          Race () : winner (-1) {}
+
+          bool over ()
+          {
+            boost::mutex::scoped_lock lock (mutex);
+            return winner >= 0;
+          }
+
+          /// Register a solution.
+          /// \return whether it is the first one.
+          bool finish (long index, const core::PathVectorPtr_t& p)
+          {
+            boost::mutex::scoped_lock lock (mutex);
+            if (winner >= 0) return false;
+            winner = index;
+            path = p;
+            return true;
+          }
+
+          boost::mutex mutex;
+          long winner;
+          core::PathVectorPtr_t path;
+        }; // struct Race
+
+        /// Run a manipulation planner step by step, until it finds a
+        /// solution or another planner of the portfolio does.
+        struct RunPlanner
+        {
+          RunPlanner (const ProblemSolverPtr_t& ps, long index,
+              size_type maxIterations, Race& race, Long& iterations,
+              value_type& time) :
+            ps_ (ps), index_ (index), maxIterations_ (maxIterations),
+            race_ (race), iterations_ (iterations), time_ (time)
+          {}
+
+          void operator() () const
+          {
+            Stopwatch watch;
+            try {
+              core::RoadmapPtr_t roadmap (ps_->roadmap ());
+              ManipulationPlannerPtr_t planner = ManipulationPlanner::create
+                (*ps_->problem (), roadmap);
+              planner->startSolve ();
+              planner->tryDirectPath ();
+              while (!roadmap->pathExists () && !race_.over ()
+                  && iterations_ < maxIterations_) {
+                planner->oneStep ();
+                ++iterations_;
+              }
+              if (roadmap->pathExists ())
+                race_.finish (index_,
+                    planner->finishSolve (planner->computePath ()));
+            } catch (const std::exception& exc) {
+              hppDout (error, "Portfolio planner " << index_ << ": "
+                  << exc.what ());
+            }
+            time_ = watch.elapsed ();
+          }
+
+          ProblemSolverPtr_t ps_;
+          long index_;
+          size_type maxIterations_;
+          Race& race_;
+          Long& iterations_;
+          value_type& time_;
+        }; // struct RunPlanner
+
+        /// Run manipulation planners in turns, in the calling thread, until
+        /// one of them finds a solution.
+        ///
+        /// The planners draw from std::rand, the generator of the process,
+        /// so they cannot run concurrently and be reproducible. Before each
+        /// step, a planner seeds the generator with the next value of its
+        /// own sequence, so that it does the same steps as if it were run
+        /// alone with its seed.
+        /// \warning This reseeds the generator of the whole process, so no
+        ///          other request must run meanwhile.
+        void runPlannersInTurn (const std::vector <ProblemSolverPtr_t>& ps,
+            const hpp::intSeq& seeds, size_type maxIterations, Race& race,
+            std::vector <Long>& iterations, vector_t& times)
+        {
+          std::size_t n = ps.size ();
+          std::vector <ManipulationPlannerPtr_t> planners (n);
+          std::vector <unsigned int> next (n);
+          std::vector <char> running (n, true);
+          for (std::size_t i = 0; i < n; ++i)
+            next[i] = (unsigned int) seeds[(ULong) i];
+
+          for (bool stepped = true; stepped && !race.over ();) {
+            stepped = false;
+            for (std::size_t i = 0; i < n && !race.over (); ++i) {
+              if (!running[i]) continue;
+              Stopwatch watch;
+              std::srand (next[i]);
+              try {
+                core::RoadmapPtr_t roadmap (ps[i]->roadmap ());
+                if (!planners[i]) {
+                  planners[i] = ManipulationPlanner::create
+                    (*ps[i]->problem (), roadmap);
+                  planners[i]->startSolve ();
+                  planners[i]->tryDirectPath ();
+                } else {
+                  planners[i]->oneStep ();
+                  ++iterations[i];
+                }
+                if (roadmap->pathExists ())
+                  race.finish ((long) i, planners[i]->finishSolve
+                      (planners[i]->computePath ()));
+                else if (iterations[i] < maxIterations)
+                  stepped = true;
+                else
+                  running[i] = false;
+              } catch (const std::exception& exc) {
+                hppDout (error, "Portfolio planner " << i << ": "
+                    << exc.what ());
+                running[i] = false;
+              }
+              next[i] = (unsigned int) std::rand ();
+              times[i] += watch.elapsed ();
+            }
+          }
+        }
+
+        /// Run a job with the requests of the thread bound to the problem
+        /// selected when it was submitted.
+        struct BoundJob
+        {
+          BoundJob (Server* server, const std::string& problem,
+              const JobQueue::Task_t& task) :
+            server_ (server), problem_ (problem), task_ (task)
+          {}
+
+          void operator() (std::vector <long>& result) const
+          {
+            ProblemLocks::Bind bind (server_, problem_);
+            try {
+              task_ (result);
+            } catch (const hpp::Error& exc) {
+              throw std::runtime_error (std::string (exc.msg));
+            }
+          }
+
+          Server* server_;
+          std::string problem_;
+          JobQueue::Task_t task_;
+        }; // struct BoundJob
+
+        struct InitializeGraphJob
+        {
+          InitializeGraphJob (Server* server) : server_ (server) {}
+
+          void operator() (std::vector <long>&) const
+          {
+            server_->graph ().initialize ();
+          }
+
+          Server* server_;
+        }; // struct InitializeGraphJob
+
+        struct AutoBuildJob
+        {
+          AutoBuildJob (Server* server, const char* graphName,
+              const Names_t& grippers, const Names_t& objects,
+              const Namess_t& handlesPerObject,
+              const Namess_t& shapesPerObject, const Names_t& envNames,
+              const Rules& rules) :
+            server_ (server), graphName_ (graphName), grippers_ (grippers),
+            objects_ (objects), handlesPerObject_ (handlesPerObject),
+            shapesPerObject_ (shapesPerObject), envNames_ (envNames),
+            rules_ (rules)
+          {}
+
+          void operator() (std::vector <long>& result) const
+          {
+            intSeq_var ids = server_->graph ().autoBuild (graphName_.c_str (),
+                grippers_, objects_, handlesPerObject_, shapesPerObject_,
+                envNames_, rules_);
+            for (ULong i = 0; i < ids->length (); ++i)
+              result.push_back (ids[i]);
+          }
+
+          Server* server_;
+          std::string graphName_;
+          Names_t grippers_, objects_;
+          Namess_t handlesPerObject_, shapesPerObject_;
+          Names_t envNames_;
+          Rules rules_;
+        }; // struct AutoBuildJob
+
+        struct BuildAndProjectPathJob
+        {
+          BuildAndProjectPathJob (Problem* problem, hpp::ID edge,
+              const hpp::floatSeq& qb, const hpp::floatSeq& qe) :
+            problem_ (problem), edge_ (edge), qb_ (qb), qe_ (qe)
+          {
+            // The servant of a problem handle may be deactivated before
+            // the job runs.
+            problem_->_add_ref ();
+            servant_ = problem_;
+          }
+
+          void operator() (std::vector <long>& result) const
+          {
+            Long notProj, proj;
+            bool success = problem_->buildAndProjectPath (edge_, qb_, qe_,
+                notProj, proj);
+            result.push_back (success);
+            result.push_back (notProj);
+            result.push_back (proj);
+          }
+
+          Problem* problem_;
+          PortableServer::ServantBase_var servant_;
+          hpp::ID edge_;
+          hpp::floatSeq qb_, qe_;
+        }; // struct BuildAndProjectPathJob
+
+        struct InsertRobotModelJob
+        {
+          InsertRobotModelJob (Server* server, const char* robotName,
+              const char* rootJointType, const char* packageName,
+              const char* modelName, const char* urdfSuffix,
+              const char* srdfSuffix) :
+            server_ (server), robotName_ (robotName),
+            rootJointType_ (rootJointType), packageName_ (packageName),
+            modelName_ (modelName), urdfSuffix_ (urdfSuffix),
+            srdfSuffix_ (srdfSuffix)
+          {}
+
+          void operator() (std::vector <long>&) const
+          {
+            server_->robot ().insertRobotModel (robotName_.c_str (),
+                rootJointType_.c_str (), packageName_.c_str (),
+                modelName_.c_str (), urdfSuffix_.c_str (),
+                srdfSuffix_.c_str ());
+          }
+
+          Server* server_;
+          std::string robotName_, rootJointType_, packageName_, modelName_,
+            urdfSuffix_, srdfSuffix_;
+        }; // struct InsertRobotModelJob
+
+        struct LoadEnvironmentModelJob
+        {
+          LoadEnvironmentModelJob (Server* server, const char* package,
+              const char* envModelName, const char* urdfSuffix,
+              const char* srdfSuffix, const char* prefix) :
+            server_ (server), package_ (package),
+            envModelName_ (envModelName), urdfSuffix_ (urdfSuffix),
+            srdfSuffix_ (srdfSuffix), prefix_ (prefix)
+          {}
+
+          void operator() (std::vector <long>&) const
+          {
+            server_->robot ().loadEnvironmentModel (package_.c_str (),
+                envModelName_.c_str (), urdfSuffix_.c_str (),
+                srdfSuffix_.c_str (), prefix_.c_str ());
+          }
+
+          Server* server_;
+          std::string package_, envModelName_, urdfSuffix_, srdfSuffix_,
+            prefix_;
+        }; // struct LoadEnvironmentModelJob
+
+        /// POA of the current request.
+        PortableServer::POA_ptr currentPOA ()
+        {
+          int argc = 0;
+          CORBA::ORB_var orb = CORBA::ORB_init (argc, NULL);
+          CORBA::Object_var obj =
+            orb->resolve_initial_references ("POACurrent");
+          PortableServer::Current_var current =
+            PortableServer::Current::_narrow (obj);
+          return current->get_POA ();
+        }
+
+        /// Activate a servant of which the requests use the problem of a
+        /// handle.
+        template <typename Servant>
+        CORBA::Object_ptr activateServant (Server* server,
+            const std::string& name, PortableServer::POA_ptr poa,
+            PortableServer::ObjectId_var& id)
+        {
+          Servant* servant = new Servant ();
+          servant->setServer (server);
+          servant->setProblemName (name);
+          id = poa->activate_object (servant);
+          // The POA owns the servant from now on.
+          servant->_remove_ref ();
+          return poa->id_to_reference (id);
+        }
+
+        template <typename Element>
+        void copyContainer (const ProblemSolverPtr_t& from,
+            const ProblemSolverPtr_t& to)
+        {
+          typedef typename CPs_t::traits <Element>::Map_t Map_t;
+          const Map_t& m = from->map <Element> ();
+          for (typename Map_t::const_iterator it = m.begin ();
+              it != m.end (); ++it)
+            to->add <Element> (it->first, it->second);
+        }
+
+        core::PathVectorPtr_t copyPathVector (const core::PathVectorPtr_t& p)
+        {
+          return HPP_STATIC_PTR_CAST (core::PathVector, p->copy ());
+        }
+
+        /// Create a problem solver with the robot, the obstacles and the
+        /// constraints of another one, a copy of its parameters and of its
+        /// constraint graph and, if required, a copy of its paths and of its
+        /// roadmap.
+        ///
+        /// The robot and the obstacles are shared. The constraints are
+        /// copied by the graph, which is rebuilt from its description.
+        /// \throw std::logic_error if the graph of src was not built by
+        ///        buildGraphFromDescription.
+        ProblemSolverPtr_t cloneProblemSolver (Graph& graphs,
+            const ProblemSolverPtr_t& src, bool copyPaths, bool copyRoadmap)
+        {
+          DevicePtr_t robot = getRobotOrThrow (src);
+          ProblemSolverPtr_t dst = ProblemSolver::create ();
+          try {
+            dst->robot (robot);
+            dst->errorThreshold (src->errorThreshold ());
+            dst->maxIterProjection (src->maxIterProjection ());
+            dst->maxIterPathPlanning (src->maxIterPathPlanning ());
+            dst->problem ()->parameters = src->problem ()->parameters;
+
+            const core::ObjectStdVector_t& collision
+              (src->collisionObstacles ());
+            const core::ObjectStdVector_t& distance
+              (src->distanceObstacles ());
+            for (core::ObjectStdVector_t::const_iterator it =
+                collision.begin (); it != collision.end (); ++it)
+              dst->addObstacle (*it, true, std::find (distance.begin (),
+                    distance.end (), *it) != distance.end ());
+            for (core::ObjectStdVector_t::const_iterator it =
+                distance.begin (); it != distance.end (); ++it)
+              if (std::find (collision.begin (), collision.end (), *it)
+                  == collision.end ())
+                dst->addObstacle (*it, false, true);
+
+            copyContainer <core::NumericalConstraintPtr_t> (src, dst);
+            copyContainer <LockedJointPtr_t> (src, dst);
+            copyContainer <JointAndShapes_t> (src, dst);
+            copyContainer <core::segments_t> (src, dst);
+
+            if (graph::GraphPtr_t g = src->constraintGraph ()) {
+              // The graph refers to the problem and to the roadmap of src,
+              // and its components set the right hand sides of their
+              // constraints.
+              graph::GraphPtr_t cg = graphs.rebuildGraph (dst, g);
+              if (!cg)
+                throw std::logic_error ("Cannot copy a graph that was not "
+                    "built by buildGraphFromDescription.");
+              dst->constraintGraph (cg);
+              dst->problem ()->constraintGraph (cg);
+            }
+
+            if (src->initConfig ()) dst->initConfig (ConfigurationPtr_t
+                (new Configuration_t (*src->initConfig ())));
+            const core::Configurations_t& goals (src->goalConfigs ());
+            for (core::Configurations_t::const_iterator it = goals.begin ();
+                it != goals.end (); ++it)
+              dst->addGoalConfig (ConfigurationPtr_t
+                  (new Configuration_t (**it)));
+
+            if (copyPaths) {
+              const core::PathVectors_t& paths (src->paths ());
+              for (core::PathVectors_t::const_iterator it = paths.begin ();
+                  it != paths.end (); ++it)
+                dst->addPath (copyPathVector (*it));
+            }
+
+            if (copyRoadmap) {
+              std::map <core::NodePtr_t, core::NodePtr_t> nodes;
+              const core::Nodes_t& n (src->roadmap ()->nodes ());
+              for (core::Nodes_t::const_iterator it = n.begin ();
+                  it != n.end (); ++it)
+                nodes[*it] = dst->roadmap ()->addNode (ConfigurationPtr_t
+                    (new Configuration_t (*(*it)->configuration ())));
+              const core::Edges_t& e (src->roadmap ()->edges ());
+              for (core::Edges_t::const_iterator it = e.begin ();
+                  it != e.end (); ++it)
+                dst->roadmap ()->addEdge (nodes[(*it)->from ()],
+                    nodes[(*it)->to ()], (*it)->path ()->copy ());
+            }
+          } catch (...) {
+            delete dst;
+            throw;
+          }
+          return dst;
+        }
+      }
+
+      Problem::ProblemPaths::ProblemPaths () :
+        retention (hpp::corbaserver::manipulation::RETAIN_IN_PROBLEM)
+      {}
+
+      Problem::Problem () : server_ (0x0), nextHandle_ (0)
+      {
       }
 
-      Problem::Problem () : server_ (0x0)
+      Problem::~Problem ()
       {
+        for (PortfolioWinners_t::iterator it = portfolioWinners_.begin ();
+            it != portfolioWinners_.end (); ++it)
+          delete it->first;
       }
 
       ProblemSolverPtr_t Problem::problemSolver ()
@@ -121,24 +871,415 @@ namespace hpp {
       bool Problem::selectProblem (const char* name)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Select, problemName_);
         std::string psName (name);
         corbaServer::ProblemSolverMapPtr_t psMap (server_->problemSolverMap());
         bool has = psMap->has (psName);
-        if (!has) psMap->map_[psName] = ProblemSolver::create ();
+        if (!has) {
+          server_->problemLocks ().erase (psName);
+          dropProblemPaths (psName);
+          psMap->map_[psName] = ProblemSolver::create ();
+        }
         psMap->selected_ = psName;
         return !has;
       }
 
       void Problem::resetProblem () throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Replace, problemName_);
         corbaServer::ProblemSolverMapPtr_t psMap (server_->problemSolverMap());
+        // The new problem solver does not share the lock of the problem it
+        // may have been cloned from.
+        server_->problemLocks ().erase (psMap->selected_);
+        dropProblemPaths (psMap->selected_);
         delete psMap->map_ [ psMap->selected_ ];
         psMap->map_ [ psMap->selected_ ]
           = manipulation::ProblemSolver::create ();
       }
 
+      void Problem::cloneProblem (const char* source, const char* target,
+          CORBA::Boolean copyRoadmap) throw (hpp::Error)
+      {
+        try {
+          std::string psName (target), sourceName;
+          ProblemSolverPtr_t clone;
+          if (!problemName_.empty ())
+            throw std::logic_error ("Cannot create a problem from a problem "
+                "handle.");
+          {
+            // Lock the source only, without changing the selection. The
+            // copy fills the lazy caches of the source graph components,
+            // so no other request may use them meanwhile.
+            ProblemLocks::Lock lock (server_, ProblemLocks::Write, source);
+            sourceName = server_->problemLocks ().bound ()->name;
+            clone = cloneProblemSolver (server_->graph (), problemSolver(),
+                true, copyRoadmap);
+          }
+          ProblemLocks::Lock lock (server_, ProblemLocks::Select);
+          corbaServer::ProblemSolverMapPtr_t psMap
+            (server_->problemSolverMap());
+          if (psMap->has (psName)) {
+            delete clone;
+            throw std::invalid_argument ("Problem " + psName
+                + " already exists.");
+          }
+          // The requests on both problems modify the robot.
+          server_->problemLocks ().share (psName, sourceName);
+          dropProblemPaths (psName);
+          psMap->map_[psName] = clone;
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Double Problem::solvePortfolio (Long nbInstances,
+          const hpp::intSeq& seeds, Long& pathId, Long& winner,
+          hpp::intSeq_out iterations, hpp::floatSeq_out times)
+        throw (hpp::Error)
+      {
+        // The planners draw from the generator of the process and share the
+        // robot, so the other requests wait.
+        ProblemLocks::Lock lock (server_, ProblemLocks::Exclusive,
+            problemName_);
+        std::vector <ProblemSolverPtr_t> clones;
+        try {
+          if (nbInstances <= 0)
+            throw std::invalid_argument ("nbInstances should be positive.");
+          if (seeds.length () != 0 && seeds.length () != (ULong) nbInstances)
+            throw std::invalid_argument ("There should be one seed per "
+                "planner, or none.");
+          ProblemSolverPtr_t ps (problemSolver());
+          graph ();
+          reserveDeviceData (getRobotOrThrow (ps), (std::size_t) nbInstances);
+
+          for (Long i = 0; i < nbInstances; ++i) {
+            // The planners modify the projectors of the graph, so each
+            // needs its own graph.
+            clones.push_back (cloneProblemSolver (server_->graph (), ps,
+                  false, false));
+            ProblemSolverPtr_t clone (clones.back ());
+            ProblemPtr_t problem (clone->problem ());
+            problem->initConfig (clone->initConfig ());
+            problem->resetGoalConfigs ();
+            const core::Configurations_t& goals (clone->goalConfigs ());
+            for (core::Configurations_t::const_iterator it = goals.begin ();
+                it != goals.end (); ++it)
+              problem->addGoalConfig (*it);
+          }
+
+          Race race;
+          std::vector <Long> iters ((std::size_t) nbInstances, 0);
+          vector_t t (vector_t::Zero (nbInstances));
+          Stopwatch watch;
+          if (seeds.length () != 0)
+            runPlannersInTurn (clones, seeds, ps->maxIterPathPlanning (),
+                race, iters, t);
+          else {
+            boost::thread_group threads;
+            for (Long i = 0; i < nbInstances; ++i)
+              threads.create_thread (RunPlanner (clones[i], i,
+                    ps->maxIterPathPlanning (), race, iters[i], t[i]));
+            threads.join_all ();
+          }
+          value_type time = watch.elapsed ();
+
+          pathId = -1;
+          winner = (Long) race.winner;
+          for (std::size_t i = 0; i < clones.size (); ++i) {
+            if ((long) i != race.winner) delete clones[i];
+          }
+          ProblemSolverPtr_t winnerPs = NULL;
+          if (race.winner >= 0) {
+            winnerPs = clones[race.winner];
+            winnerPs->roadmap ()->clear ();
+          }
+          clones.clear ();
+
+          if (race.path) {
+            // As in ProblemSolver::solve, keep the path found by the planner
+            // and the result of each path optimizer.
+            std::size_t first = ps->paths ().size ();
+            ps->addPath (race.path);
+            std::string error;
+            try {
+              ps->optimizePath (race.path);
+            } catch (const std::exception& exc) {
+              error = exc.what ();
+            }
+            // The solutions refer to the graph of the winner, which refers
+            // to its problem.
+            server_->problem ().keepPortfolioWinner (winnerPs,
+                core::PathVectors_t (ps->paths ().begin () + first,
+                  ps->paths ().end ()));
+            if (!error.empty ()) throw std::runtime_error (error);
+            pathId = (Long) ps->paths ().size () - 1;
+          } else
+            delete winnerPs;
+
+          iterations = toIntSeq (iters.begin (), iters.end ());
+          times = vectorToFloatSeq (t);
+          return time;
+        } catch (const std::exception& exc) {
+          for (std::size_t i = 0; i < clones.size (); ++i) delete clones[i];
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      void Problem::keepPortfolioWinner (const ProblemSolverPtr_t& winner,
+          const core::PathVectors_t& paths)
+      {
+        boost::mutex::scoped_lock lock (portfolioMutex_);
+        for (PortfolioWinners_t::iterator it = portfolioWinners_.begin ();
+            it != portfolioWinners_.end ();) {
+          bool erased = true;
+          for (std::size_t i = 0; i < it->second.size (); ++i)
+            if (!it->second[i].expired ()) erased = false;
+          if (erased) {
+            delete it->first;
+            it = portfolioWinners_.erase (it);
+          } else ++it;
+        }
+        portfolioWinners_.push_back (std::make_pair (winner,
+              std::vector <core::PathVectorWkPtr_t> (paths.begin (),
+                paths.end ())));
+      }
+
+      Long Problem::submitJob (const JobQueue::Task_t& task)
+      {
+        try {
+          std::string psName;
+          {
+            ProblemLocks::Lock lock (server_, ProblemLocks::Read,
+                problemName_);
+            psName = server_->problemLocks ().bound ()->name;
+          }
+          return (Long) server_->jobQueue ().submit
+            (BoundJob (server_, psName, task));
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Long Problem::submitInitializeGraph () throw (hpp::Error)
+      {
+        return submitJob (InitializeGraphJob (server_));
+      }
+
+      Long Problem::submitAutoBuild (const char* graphName,
+          const Names_t& grippers, const Names_t& objects,
+          const Namess_t& handlesPerObject, const Namess_t& shapesPerObject,
+          const Names_t& envNames, const Rules& rulesList)
+        throw (hpp::Error)
+      {
+        return submitJob (AutoBuildJob (server_, graphName, grippers, objects,
+              handlesPerObject, shapesPerObject, envNames, rulesList));
+      }
+
+      Long Problem::submitBuildAndProjectPath (hpp::ID IDedge,
+          const hpp::floatSeq& qb, const hpp::floatSeq& qe)
+        throw (hpp::Error)
+      {
+        return submitJob (BuildAndProjectPathJob (this, IDedge, qb, qe));
+      }
+
+      Long Problem::submitInsertRobotModel (const char* robotName,
+          const char* rootJointType, const char* packageName,
+          const char* modelName, const char* urdfSuffix,
+          const char* srdfSuffix)
+        throw (hpp::Error)
+      {
+        return submitJob (InsertRobotModelJob (server_, robotName,
+              rootJointType, packageName, modelName, urdfSuffix, srdfSuffix));
+      }
+
+      Long Problem::submitLoadEnvironmentModel (const char* package,
+          const char* envModelName, const char* urdfSuffix,
+          const char* srdfSuffix, const char* prefix)
+        throw (hpp::Error)
+      {
+        return submitJob (LoadEnvironmentModelJob (server_, package,
+              envModelName, urdfSuffix, srdfSuffix, prefix));
+      }
+
+      JobState Problem::getJobState (Long jobId, Double& elapsed,
+          CORBA::String_out error)
+        throw (hpp::Error)
+      {
+        try {
+          std::string err;
+          value_type t;
+          JobQueue::State state = server_->jobQueue ().state (jobId, t, err);
+          elapsed = t;
+          error = CORBA::string_dup (err.c_str ());
+          namespace cm = hpp::corbaserver::manipulation;
+          switch (state) {
+            case JobQueue::Pending:   return cm::JOB_PENDING;
+            case JobQueue::Running:   return cm::JOB_RUNNING;
+            case JobQueue::Done:      return cm::JOB_DONE;
+            case JobQueue::Failed:    return cm::JOB_FAILED;
+            case JobQueue::Cancelled:
+            default:                  return cm::JOB_CANCELLED;
+          }
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      CORBA::Boolean Problem::cancelJob (Long jobId) throw (hpp::Error)
+      {
+        try {
+          return server_->jobQueue ().cancel (jobId);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      intSeq* Problem::getJobResult (Long jobId) throw (hpp::Error)
+      {
+        try {
+          std::vector <long> result = server_->jobQueue ().result (jobId);
+          return toIntSeq (result.begin (), result.end ());
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      struct Problem::ProblemHandle
+      {
+        ProblemHandle (const std::string& n) : name (n) {}
+
+        ~ProblemHandle ()
+        {
+          if (CORBA::is_nil (poa)) return;
+          try {
+            // The POA deletes the servants once their requests are over.
+            poa->deactivate_object (graphId);
+            poa->deactivate_object (problemId);
+            poa->deactivate_object (robotId);
+          } catch (const CORBA::Exception&) {
+            hppDout (error, "Failed to deactivate the servants of problem "
+                << name);
+          }
+        }
+
+        std::string name;
+        PortableServer::POA_var poa;
+        PortableServer::ObjectId_var graphId, problemId, robotId;
+        hpp::corbaserver::manipulation::Graph_var graph;
+        hpp::corbaserver::manipulation::Problem_var problem;
+        hpp::corbaserver::manipulation::Robot_var robot;
+      }; // struct ProblemHandle
+
+      Long Problem::openProblemHandle (const char* name) throw (hpp::Error)
+      {
+        std::string psName (name);
+        {
+          ProblemLocks::Lock lock (server_, ProblemLocks::Select,
+              problemName_);
+          corbaServer::ProblemSolverMapPtr_t psMap
+            (server_->problemSolverMap());
+          if (!psMap->has (psName)) {
+            server_->problemLocks ().erase (psName);
+            dropProblemPaths (psName);
+            psMap->map_[psName] = ProblemSolver::create ();
+          }
+        }
+        // The handles are kept by the main servant, where
+        // closeProblemHandle and getProblemHandleInterfaces look for them.
+        Problem& p (server_->problem ());
+        boost::mutex::scoped_lock lock (p.handlesMutex_);
+        p.handles_[p.nextHandle_].reset (new ProblemHandle (psName));
+        return p.nextHandle_++;
+      }
+
+      void Problem::closeProblemHandle (Long handle) throw (hpp::Error)
+      {
+        // The handles are held by the servant of the selected problem.
+        Problem& p (server_->problem ());
+        // Deactivate the interfaces of the handle once the lock is released.
+        ProblemHandlePtr_t h;
+        {
+          boost::mutex::scoped_lock lock (p.handlesMutex_);
+          std::map <Long, ProblemHandlePtr_t>::iterator it =
+            p.handles_.find (handle);
+          if (it == p.handles_.end ())
+            throw Error ("Invalid problem handle.");
+          h = it->second;
+          p.handles_.erase (it);
+        }
+      }
+
+      char* Problem::getProblemHandleName (Long handle) throw (hpp::Error)
+      {
+        try {
+          return CORBA::string_dup (problemHandle (handle)->name.c_str ());
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      void Problem::getProblemHandleInterfaces (Long handle,
+          hpp::corbaserver::manipulation::Graph_out graph,
+          hpp::corbaserver::manipulation::Problem_out problem,
+          hpp::corbaserver::manipulation::Robot_out robot)
+        throw (hpp::Error)
+      {
+        namespace cm = hpp::corbaserver::manipulation;
+        try {
+          ProblemHandlePtr_t h (problemHandle (handle));
+          boost::mutex::scoped_lock lock (server_->problem ().handlesMutex_);
+          if (CORBA::is_nil (h->poa)) {
+            PortableServer::POA_var poa (currentPOA ());
+            CORBA::Object_var obj;
+            obj = activateServant <Graph> (server_, h->name, poa, h->graphId);
+            h->graph = cm::Graph::_narrow (obj);
+            obj = activateServant <Problem> (server_, h->name, poa,
+                h->problemId);
+            h->problem = cm::Problem::_narrow (obj);
+            obj = activateServant <Robot> (server_, h->name, poa, h->robotId);
+            h->robot = cm::Robot::_narrow (obj);
+            h->poa = poa._retn ();
+          }
+          graph = cm::Graph::_duplicate (h->graph);
+          problem = cm::Problem::_duplicate (h->problem);
+          robot = cm::Robot::_duplicate (h->robot);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        } catch (const CORBA::Exception&) {
+          throw hpp::Error ("Failed to activate the interfaces of the "
+              "problem handle.");
+        }
+      }
+
+      Problem::ProblemHandlePtr_t Problem::problemHandle (Long handle)
+      {
+        Problem& p (server_->problem ());
+        boost::mutex::scoped_lock lock (p.handlesMutex_);
+        std::map <Long, ProblemHandlePtr_t>::const_iterator it =
+          p.handles_.find (handle);
+        if (it == p.handles_.end ())
+          throw std::invalid_argument ("Invalid problem handle.");
+        return it->second;
+      }
+
+      Double Problem::solve (Long handle, Long& pathId) throw (hpp::Error)
+      {
+        try {
+          ProblemLocks::Lock lock (server_, ProblemLocks::Write,
+              problemHandle (handle)->name);
+          ProblemSolverPtr_t ps (problemSolver());
+          Stopwatch watch;
+          ps->solve ();
+          pathId = (Long) ps->paths ().size () - 1;
+          return watch.elapsed ();
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
       Names_t* Problem::getAvailable (const char* what) throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         std::string w (what);
         boost::algorithm::to_lower(w);
         typedef std::list <std::string> Ret_t;
@@ -178,6 +1319,7 @@ namespace hpp {
 				 const char* handleName)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           problemSolver()->createGraspConstraint
             (graspName, gripperName, handleName);
@@ -191,6 +1333,7 @@ namespace hpp {
                                     const char* handleName)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           problemSolver()->createPreGraspConstraint
             (graspName, gripperName, handleName);
@@ -202,6 +1345,7 @@ namespace hpp {
       Names_t* Problem::getEnvironmentContactNames ()
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         try {
 	  typedef std::map<std::string, JointAndShapes_t> ShapeMap;
 	  const ShapeMap& m = problemSolver()->map <JointAndShapes_t> ();
@@ -226,6 +1370,7 @@ namespace hpp {
       Names_t* Problem::getRobotContactNames ()
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         try {
           typedef std::map<std::string, JointAndShapes_t> ShapeMap;
           DevicePtr_t r = getRobotOrThrow (problemSolver());
@@ -252,6 +1397,7 @@ namespace hpp {
             intSeq_out indexes, floatSeqSeq_out points)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         try {
 	  const JointAndShapes_t& js =
             problemSolver()->get <JointAndShapes_t> (name);
@@ -266,6 +1412,7 @@ namespace hpp {
             intSeq_out indexes, hpp::floatSeqSeq_out points)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         try {
           DevicePtr_t r = getRobotOrThrow (problemSolver());
 	  const JointAndShapes_t& js = r->get <JointAndShapes_t> (name);
@@ -281,6 +1428,7 @@ namespace hpp {
 					       const Names_t& surface2)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
 	  problemSolver()->createPlacementConstraint (placName,
               toStringList(surface1), toStringList(surface2), 1e-3);
@@ -295,6 +1443,7 @@ namespace hpp {
                                                   CORBA::Double width)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
 	  problemSolver()->createPrePlacementConstraint (placName,
               toStringList(surface1), toStringList(surface2), width, 1e-3);
@@ -307,6 +1456,7 @@ namespace hpp {
           const Names_t& shapesName)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
 #ifdef HPP_CONSTRAINTS_USE_QPOASES
 	  // Get robot in hppPlanner object.
@@ -359,41 +1509,48 @@ namespace hpp {
 	}
       }
 
+      ConstraintSetPtr_t Problem::configConstraint (hpp::ID id)
+      {
+        ConstraintSetPtr_t constraint;
+        graph::GraphComponentPtr_t comp = graph()->get ((size_t)id).lock ();
+        graph::EdgePtr_t edge = HPP_DYNAMIC_PTR_CAST(graph::Edge, comp);
+        graph::StatePtr_t state = HPP_DYNAMIC_PTR_CAST(graph::State, comp);
+        if (edge) {
+          constraint = graph(false)->configConstraint (edge);
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          if (core::ConfigProjectorPtr_t cp =
+              constraint->configProjector ()) {
+            rhsCache_.rightHandSideFromConfig (cp,
+                robot->currentConfiguration());
+          }
+        } else if (state)
+          constraint = graph(false)->configConstraint (state);
+        else {
+          std::stringstream ss;
+          ss << "ID " << id << " is neither an edge nor a state";
+          std::string errmsg = ss.str();
+          throw Error (errmsg.c_str());
+        }
+        return constraint;
+      }
+
       bool Problem::applyConstraints (hpp::ID id,
           const hpp::floatSeq& input,
           hpp::floatSeq_out output,
           double& residualError)
         throw (hpp::Error)
       {
-        /// First get the constraint.
-        ConstraintSetPtr_t constraint;
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         try {
-          graph::GraphComponentPtr_t comp = graph()->get ((size_t)id).lock ();
-          graph::EdgePtr_t edge = HPP_DYNAMIC_PTR_CAST(graph::Edge, comp);
-          graph::StatePtr_t state = HPP_DYNAMIC_PTR_CAST(graph::State, comp);
-          if (edge) {
-            constraint = graph(false)->configConstraint (edge);
-            DevicePtr_t robot = getRobotOrThrow (problemSolver());
-	    if (core::ConfigProjectorPtr_t cp =
-		constraint->configProjector ()) {
-	      cp->rightHandSideFromConfig (robot->currentConfiguration());
-	    }
-          } else if (state)
-            constraint = graph(false)->configConstraint (state);
-          else {
-            std::stringstream ss;
-            ss << "ID " << id << " is neither an edge nor a state";
-            std::string errmsg = ss.str();
-            throw Error (errmsg.c_str());
-          }
+          /// First get the constraint.
+          ConstraintSetPtr_t constraint = configConstraint (id);
 	  bool success = false;
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  ConfigurationPtr_t config = floatSeqToConfigPtr (robot, input, true);
-	  success = constraint->apply (*config);
-	  if (hpp::core::ConfigProjectorPtr_t configProjector =
-	      constraint ->configProjector ()) {
-	    residualError = configProjector->residualError ();
-	  }
+          ProjectionProfiler::Profile profile;
+          success = project (constraint, warmStart_, &warmStart_, graph (),
+              id, *config, residualError, profile);
+          server_->projectionProfiler ().record (graph (), id, profile);
 	  output = vectorToFloatSeq(*config);
 	  return success;
 	} catch (const std::exception& exc) {
@@ -401,6 +1558,207 @@ namespace hpp {
 	}
       }
 
+      Long Problem::applyConstraintsBatch (hpp::ID id,
+          const hpp::floatSeqSeq& inputs,
+          hpp::floatSeqSeq_out outputs,
+          hpp::Bools_t_out success,
+          hpp::floatSeq_out residualErrors)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          ConstraintSetPtr_t constraint = configConstraint (id);
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          std::vector <Configuration_t> qs = floatSeqSeqToConfigs
+            (robot, inputs);
+
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          std::vector <ConstraintSetPtr_t> copies (pool.size ());
+          std::vector <char> succ (qs.size (), false);
+          vector_t residuals (vector_t::Zero (qs.size ()));
+          std::vector <ProjectionProfiler::Profile> profiles (pool.size ());
+          graph::GraphPtr_t g (graph ());
+          // The projections are seeded from the solutions known before the
+          // batch, and their own solutions are stored after it, in the
+          // order of the inputs, so that the outputs do not depend on the
+          // scheduling of the threads.
+          WarmStartStore seeds;
+          seeds.copy (warmStart_, g);
+          std::vector <Configuration_t> initial;
+          if (seeds.enabled ()) initial = qs;
+          pool.parallelFor (qs.size (), ApplyConstraints (constraint,
+                seeds, g, id, copies, qs, succ, residuals, profiles));
+          core::ConfigProjectorPtr_t cp = constraint->configProjector ();
+          for (std::size_t i = 0; i < initial.size (); ++i)
+            if (succ[i]) warmStart_.add (g, id, cp, initial[i], qs[i]);
+
+          for (std::size_t i = 1; i < profiles.size (); ++i)
+            profiles[0].merge (profiles[i]);
+          server_->projectionProfiler ().record (graph (), id, profiles[0]);
+
+          outputs = configsToFloatSeqSeq (qs);
+          success = toBools_t (succ.begin (), succ.end ());
+          residualErrors = vectorToFloatSeq (residuals);
+          return (Long) std::count (succ.begin (), succ.end (), true);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      void Problem::benchmarkProjection (hpp::ID id,
+          const hpp::floatSeqSeq& inputs, hpp::floatSeq_out times,
+          hpp::intSeq_out nbSuccess)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          ConstraintSetPtr_t constraint = configConstraint (id);
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          const std::vector <Configuration_t> qs = floatSeqSeqToConfigs
+            (robot, inputs);
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          graph::GraphPtr_t g (graph ());
+          // Disabled, so that both runs project from the inputs.
+          WarmStartStore noWarmStart;
+
+          vector_t t (2);
+          std::vector <Long> nb (2);
+          for (std::size_t run = 0; run < 2; ++run) {
+            bool batch = (run == 1);
+            std::size_t nbThreads = (batch ? pool.size () : 1);
+            std::vector <Configuration_t> q (qs);
+            std::vector <ConstraintSetPtr_t> copies (nbThreads);
+            std::vector <char> succ (q.size (), false);
+            vector_t residuals (vector_t::Zero (q.size ()));
+            std::vector <ProjectionProfiler::Profile> profiles (nbThreads);
+            ApplyConstraints apply (constraint, noWarmStart, g, id, copies,
+                q, succ, residuals, profiles);
+            // The constraints are copied before the timing.
+            for (std::size_t j = 0; j < nbThreads; ++j)
+              copies[j] = copyConstraintSet (constraint);
+            Stopwatch watch;
+            if (batch) pool.parallelFor (q.size (), apply);
+            else
+              for (std::size_t i = 0; i < q.size (); ++i) apply (i, 0);
+            t[run] = watch.elapsed ();
+            nb[run] = (Long) std::count (succ.begin (), succ.end (), true);
+          }
+          times = vectorToFloatSeq (t);
+          nbSuccess = toIntSeq (nb.begin (), nb.end ());
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Long Problem::isConfigValidBatch (const hpp::floatSeqSeq& configs,
+          CORBA::Boolean withCollisionPairs, hpp::Bools_t_out valid,
+          hpp::Names_t_out objects1, hpp::Names_t_out objects2)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          const std::vector <Configuration_t> qs = floatSeqSeqToConfigs
+            (robot, configs);
+          core::ConfigValidationsPtr_t validations =
+            problemSolver()->problem ()->configValidations ();
+
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          std::vector <char> v (qs.size (), false);
+          std::vector <std::string> o1, o2;
+          if (withCollisionPairs) {
+            o1.resize (qs.size ());
+            o2.resize (qs.size ());
+          }
+          pool.parallelFor (qs.size (), ValidateConfigurations (validations,
+                qs, v, withCollisionPairs, o1, o2));
+
+          valid = toBools_t (v.begin (), v.end ());
+          objects1 = toNames_t (o1.begin (), o1.end ());
+          objects2 = toNames_t (o2.begin (), o2.end ());
+          return (Long) std::count (v.begin (), v.end (), true);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Long Problem::sampleStateConfigurations (hpp::ID stateId, Long count,
+          Long maxAttempts, hpp::floatSeqSeq_out configs,
+          Double& acceptanceRate, hpp::floatSeq_out phaseTimes)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          if (count < 0 || maxAttempts < 0)
+            throw std::invalid_argument
+              ("count and maxAttempts should be positive.");
+          graph::StatePtr_t state = HPP_DYNAMIC_PTR_CAST (graph::State,
+              graph()->get ((size_t)stateId).lock ());
+          if (!state) {
+            HPP_THROW (std::invalid_argument, "ID " << stateId
+                << " is not a state.");
+          }
+          ConstraintSetPtr_t constraint = graph(false)->configConstraint
+            (state);
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          ProblemPtr_t problem = problemSolver()->problem ();
+          core::ConfigurationShooterPtr_t shooter =
+            problem->configurationShooter ();
+          core::ConfigValidationsPtr_t validations =
+            problem->configValidations ();
+
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          std::vector <ConstraintSetPtr_t> copies (pool.size ());
+          std::vector <ProjectionProfiler::Profile> profiles (pool.size ());
+          vector_t validationTimes (vector_t::Zero (pool.size ()));
+          value_type shootTime = 0;
+
+          std::vector <Configuration_t> samples;
+          std::size_t attempts = 0;
+          while ((Long) samples.size () < count
+              && (Long) attempts < maxAttempts) {
+            // Shoot more configurations than missing, since most of them
+            // are usually rejected.
+            std::size_t n = std::min ((std::size_t) (maxAttempts - attempts),
+                std::max (4 * (count - samples.size ()), pool.size ()));
+            std::vector <Configuration_t> qs (n);
+            // The configuration shooter uses a random generator shared with
+            // the rest of the problem.
+            Stopwatch shoot;
+            for (std::size_t i = 0; i < n; ++i)
+              qs[i] = *shooter->shoot ();
+            shootTime += shoot.elapsed ();
+
+            std::vector <char> valid (n, false);
+            pool.parallelFor (n, SampleConfigurations (constraint,
+                  validations, copies, qs, valid, profiles, validationTimes));
+            attempts += n;
+            for (std::size_t i = 0; i < n
+                && (Long) samples.size () < count; ++i)
+              if (valid[i]) samples.push_back (qs[i]);
+          }
+
+          for (std::size_t i = 1; i < profiles.size (); ++i)
+            profiles[0].merge (profiles[i]);
+          server_->projectionProfiler ().record (graph (), stateId,
+              profiles[0]);
+
+          configs = configsToFloatSeqSeq (samples);
+          acceptanceRate = (attempts == 0 ? 0 :
+              (Double) samples.size () / (Double) attempts);
+          vector_t times (3);
+          times << shootTime, profiles[0].totalTime, validationTimes.sum ();
+          phaseTimes = vectorToFloatSeq (times);
+          return (Long) attempts;
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
       bool Problem::applyConstraintsWithOffset (hpp::ID IDedge,
           const hpp::floatSeq& qnear,
           const hpp::floatSeq& input,
@@ -408,6 +1766,7 @@ namespace hpp {
           double& residualError)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         /// First get the constraint.
         graph::EdgePtr_t edge;
         try {
@@ -422,21 +1781,49 @@ namespace hpp {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  ConfigurationPtr_t config = floatSeqToConfigPtr (robot, input, true);
 	  ConfigurationPtr_t qoffset = floatSeqToConfigPtr (robot, qnear, true);
-          value_type dist = 0;
-          core::NodePtr_t nNode = problemSolver()->roadmap()->nearestNode
-	    (qoffset, dist);
-          if (dist < 1e-8)
-            success = edge->applyConstraints (nNode, *config);
-          else
-            success = edge->applyConstraints (*qoffset, *config);
+          // Look for a node at qoffset in the index first, and fall back
+          // to the nearest node within the tolerance.
+          core::RoadmapPtr_t roadmap (problemSolver()->roadmap());
+          core::NodePtr_t nNode = server_->roadmapIndex ().find
+            (roadmap, *qoffset);
+          if (!nNode) {
+            value_type dist = 0;
+            nNode = roadmap->nearestNode (qoffset, dist);
+            if (dist >= 1e-8) nNode = NULL;
+          }
+          Stopwatch watch;
+          if (HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge, edge)
+              || HPP_DYNAMIC_PTR_CAST (graph::LevelSetEdge, edge)) {
+            if (nNode)
+              success = edge->applyConstraints (nNode, *config);
+            else
+              success = edge->applyConstraints (*qoffset, *config);
+          } else {
+            // Same as graph::Edge::applyConstraints, with the right hand
+            // side of the leaf taken from the cache.
+            if (nNode) qoffset = nNode->configuration ();
+            ConstraintSetPtr_t constraint = edge->configConstraint ();
+            if (core::ConfigProjectorPtr_t cp =
+                constraint->configProjector ())
+              rhsCache_.rightHandSideFromConfig (cp, *qoffset);
+            if (edge->isShort ()) *config = *qoffset;
+            success = constraint->apply (*config);
+          }
+          value_type time = watch.elapsed ();
 
 	  hpp::core::ConfigProjectorPtr_t configProjector
 	    (edge->configConstraint ()->configProjector ());
+          ProjectionProfiler::Profile profile;
+          value_type residual = 0;
 	  if (configProjector) {
 	    residualError = configProjector->residualError ();
+            residual = residualError;
 	  } else {
 	    hppDout (info, "No config projector.");
 	  }
+          profile.add (time, success, residual);
+          server_->projectionProfiler ().record (graph (), edge->id (),
+              profile);
 	  ULong size = (ULong) config->size ();
 	  hpp::floatSeq* q_ptr = new hpp::floatSeq ();
 	  q_ptr->length (size);
@@ -451,6 +1838,162 @@ namespace hpp {
 	}
       }
 
+      Long Problem::probeOutgoingEdges (const hpp::floatSeq& q1,
+          const hpp::floatSeq& q2, hpp::ID& stateId, hpp::IDseq_out edgeIds,
+          hpp::floatSeqSeq_out outputs, hpp::Bools_t_out success,
+          hpp::floatSeq_out residualErrors)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          Configuration_t qfrom =
+            corbaServer::floatSeqToConfig (robot, q1, true);
+          Configuration_t qto =
+            corbaServer::floatSeqToConfig (robot, q2, true);
+          graph::GraphPtr_t g (graph ());
+          graph::StatePtr_t state = g->getState (qfrom);
+          graph::Edges_t edges = state->neighborEdges ();
+
+          std::vector <Configuration_t> qs (edges.size (), qto);
+          std::vector <char> succ (edges.size (), false);
+          vector_t residuals (vector_t::Zero (edges.size ()));
+          std::vector <ProjectionProfiler::Profile> profiles (edges.size ());
+          // Waypoint and level set edges modify their own state, so they
+          // are probed afterwards, by this thread.
+          std::vector <ConstraintSetPtr_t> constraints (edges.size ());
+          for (std::size_t i = 0; i < edges.size (); ++i) {
+            if (!HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge, edges[i])
+                && !HPP_DYNAMIC_PTR_CAST (graph::LevelSetEdge, edges[i]))
+              constraints[i] = edges[i]->configConstraint ();
+          }
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          pool.parallelFor (edges.size (), ProbeEdges (edges, constraints,
+                qfrom, qs, succ, residuals, profiles));
+
+          for (std::size_t i = 0; i < edges.size (); ++i) {
+            if (constraints[i]) continue;
+            Stopwatch watch;
+            succ[i] = edges[i]->applyConstraints (qfrom, qs[i]);
+            if (core::ConfigProjectorPtr_t cp =
+                edges[i]->configConstraint ()->configProjector ())
+              residuals[i] = cp->residualError ();
+            profiles[i].add (watch.elapsed (), succ[i], residuals[i]);
+          }
+
+          for (std::size_t i = 0; i < edges.size (); ++i)
+            server_->projectionProfiler ().record (g, edges[i]->id (),
+                profiles[i]);
+
+          stateId = (hpp::ID) state->id ();
+          hpp::IDseq* ids = new hpp::IDseq ();
+          ids->length ((ULong) edges.size ());
+          for (std::size_t i = 0; i < edges.size (); ++i)
+            (*ids)[(ULong) i] = (hpp::ID) edges[i]->id ();
+          edgeIds = ids;
+          outputs = configsToFloatSeqSeq (qs);
+          success = toBools_t (succ.begin (), succ.end ());
+          residualErrors = vectorToFloatSeq (residuals);
+          return (Long) std::count (succ.begin (), succ.end (), true);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Long Problem::generateTargetConfigs (hpp::ID IDedge,
+          const hpp::floatSeqSeq& qfroms, const hpp::floatSeqSeq& inputs,
+          hpp::floatSeqSeq_out outputs, hpp::Bools_t_out success,
+          hpp::floatSeq_out residualErrors, hpp::intSeq_out leaves)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          graph::EdgePtr_t edge = HPP_DYNAMIC_PTR_CAST (graph::Edge,
+              graph()->get ((size_t)IDedge).lock ());
+          if (!edge) {
+            HPP_THROW (std::invalid_argument, "ID " << IDedge
+                << " is not an edge");
+          }
+          if (qfroms.length () != inputs.length ())
+            throw std::invalid_argument ("There should be as many sources as "
+                "input configurations.");
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          std::vector <Configuration_t> sources = floatSeqSeqToConfigs
+            (robot, qfroms);
+          std::vector <Configuration_t> qs = floatSeqSeqToConfigs
+            (robot, inputs);
+          std::size_t n = qs.size ();
+          std::vector <char> succ (n, false);
+          vector_t residuals (vector_t::Zero (n));
+          std::vector <Long> leafOfInput (n, -1);
+          std::vector <ProjectionProfiler::Profile> profiles (1);
+          ConstraintSetPtr_t constraint = edge->configConstraint ();
+
+          if (HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge, edge)
+              || HPP_DYNAMIC_PTR_CAST (graph::LevelSetEdge, edge)) {
+            // These edges generate targets in their own way.
+            for (std::size_t i = 0; i < n; ++i) {
+              Stopwatch watch;
+              succ[i] = edge->applyConstraints (sources[i], qs[i]);
+              if (core::ConfigProjectorPtr_t cp =
+                  constraint->configProjector ())
+                residuals[i] = cp->residualError ();
+              profiles[0].add (watch.elapsed (), succ[i], residuals[i]);
+            }
+          } else {
+            if (edge->isShort ())
+              for (std::size_t i = 0; i < n; ++i) qs[i] = sources[i];
+
+            // Compute the right hand side once per distinct source.
+            typedef std::map <vector_t, std::size_t, VectorLess> Indexes_t;
+            Indexes_t sourceIndexes;
+            std::vector <Configuration_t> distinct;
+            std::vector <std::size_t> sourceOfInput (n);
+            for (std::size_t i = 0; i < n; ++i) {
+              std::pair <Indexes_t::iterator, bool> res = sourceIndexes.insert
+                (std::make_pair (sources[i], distinct.size ()));
+              if (res.second) distinct.push_back (sources[i]);
+              sourceOfInput[i] = res.first->second;
+            }
+
+            ThreadPool& pool (server_->threadPool ());
+            reserveDeviceData (robot, pool.size ());
+            std::vector <ConstraintSetPtr_t> copies (pool.size ());
+            std::vector <vector_t> rhs (distinct.size ());
+            pool.parallelFor (distinct.size (), ComputeRightHandSides
+                (constraint, copies, distinct, rhs));
+
+            // Sources with the same right hand side lie on the same leaf.
+            Indexes_t leafIndexes;
+            std::vector <vector_t> leafRhs;
+            for (std::size_t i = 0; i < n; ++i) {
+              const vector_t& r (rhs[sourceOfInput[i]]);
+              std::pair <Indexes_t::iterator, bool> res = leafIndexes.insert
+                (std::make_pair (r, leafRhs.size ()));
+              if (res.second) leafRhs.push_back (r);
+              leafOfInput[i] = (Long) res.first->second;
+            }
+
+            profiles.resize (pool.size ());
+            pool.parallelFor (n, GenerateTargets (constraint, copies, leafRhs,
+                  leafOfInput, qs, succ, residuals, profiles));
+            for (std::size_t i = 1; i < profiles.size (); ++i)
+              profiles[0].merge (profiles[i]);
+          }
+          server_->projectionProfiler ().record (graph (), edge->id (),
+              profiles[0]);
+
+          outputs = configsToFloatSeqSeq (qs);
+          success = toBools_t (succ.begin (), succ.end ());
+          residualErrors = vectorToFloatSeq (residuals);
+          leaves = toIntSeq (leafOfInput.begin (), leafOfInput.end ());
+          return (Long) std::count (succ.begin (), succ.end (), true);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
       bool Problem::buildAndProjectPath (hpp::ID IDedge,
           const hpp::floatSeq& qb,
           const hpp::floatSeq& qe,
@@ -458,6 +2001,7 @@ namespace hpp {
           CORBA::Long& indexProj)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         /// First get the constraint.
         graph::EdgePtr_t edge;
         try {
@@ -479,56 +2023,266 @@ namespace hpp {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  ConfigurationPtr_t q1 = floatSeqToConfigPtr (robot, qb, true);
 	  ConfigurationPtr_t q2 = floatSeqToConfigPtr (robot, qe, true);
-	  core::PathVectorPtr_t pv;
 	  indexNotProj = -1;
 	  indexProj = -1;
           core::PathPtr_t path;
 	  success = edge->build (path, *q1, *q2);
           if (!success) return false;
-          pv = HPP_DYNAMIC_PTR_CAST (core::PathVector, path);
-          indexNotProj = (CORBA::Long) problemSolver()->paths ().size ();
-          if (!pv) {
-            pv = core::PathVector::create (path->outputSize (),
-                path->outputDerivativeSize ());
-            pv->appendPath (path);
-          }
-          problemSolver()->addPath (pv);
+          indexNotProj = storePath (path);
 
           core::PathPtr_t projPath;
-	  PathProjectorPtr_t pathProjector
-	    (problemSolver()->problem()->pathProjector ());
-	  if (!pathProjector) {
-	    problemSolver ()->initPathProjector ();
-	    pathProjector =
-	      problemSolver()->problem()->pathProjector ();
-	  }
+	  PathProjectorPtr_t pathProjector = initPathProjector ();
 	  if (pathProjector) {
 	    success = pathProjector->apply (path, projPath);
 	  } else {
 	    success = true;
-	    projPath = path->copy ();
+	    projPath = (sharePaths () ? path : path->copy ());
 	  }
 
           if (!success) {
             if (!projPath || projPath->length () == 0)
               return false;
           }
-          pv = HPP_DYNAMIC_PTR_CAST (core::PathVector, projPath);
-          indexProj = (CORBA::Long) problemSolver()->paths ().size ();
-          if (!pv) {
-            pv = core::PathVector::create (projPath->outputSize (),
-                projPath->outputDerivativeSize ());
-            pv->appendPath (projPath);
-          }
-          problemSolver()->addPath (pv);
+          indexProj = (projPath == path && sharePaths () ? indexNotProj :
+              storePath (projPath));
 	  return success;
 	} catch (const std::exception& exc) {
 	  throw hpp::Error (exc.what ());
 	}
       }
 
+      Problem::ProblemPathsPtr_t Problem::problemPaths ()
+      {
+        const ProblemLocks::Binding* binding =
+          server_->problemLocks ().bound ();
+        assert (binding && binding->problemSolver);
+        // The handles of a problem use its paths too.
+        Problem& p (server_->problem ());
+        boost::mutex::scoped_lock lock (p.problemPathsMutex_);
+        std::pair <ProblemSolverPtr_t, ProblemPathsPtr_t>& entry =
+          p.problemPaths_[binding->name];
+        // The problem solver was replaced without dropping its paths.
+        if (entry.first != binding->problemSolver || !entry.second) {
+          entry.first = binding->problemSolver;
+          entry.second.reset (new ProblemPaths ());
+        }
+        return entry.second;
+      }
+
+      void Problem::dropProblemPaths (const std::string& name)
+      {
+        Problem& p (server_->problem ());
+        boost::mutex::scoped_lock lock (p.problemPathsMutex_);
+        p.problemPaths_.erase (name);
+      }
+
+      bool Problem::sharePaths ()
+      {
+        return problemPaths ()->retention !=
+          hpp::corbaserver::manipulation::RETAIN_IN_PROBLEM;
+      }
+
+      Long Problem::storePath (const core::PathPtr_t& path)
+      {
+        ProblemPathsPtr_t paths (problemPaths ());
+        switch (paths->retention) {
+          case hpp::corbaserver::manipulation::RETAIN_IN_STORE:
+            return (Long) paths->store.add (asPathVector (path));
+          case hpp::corbaserver::manipulation::DISCARD:
+            return -2;
+          default:
+            // RETAIN_IN_PROBLEM and RETAIN_IN_PROBLEM_SHARED
+            Long index = (Long) problemSolver()->paths ().size ();
+            problemSolver()->addPath (asPathVector (path));
+            return index;
+        }
+      }
+
+      PathProjectorPtr_t Problem::initPathProjector ()
+      {
+        ProblemPtr_t problem = problemSolver()->problem ();
+        if (!problem->steeringMethod () ||
+            !problem->steeringMethod ()->innerSteeringMethod ())
+          problemSolver ()->initSteeringMethod ();
+        if (!problem->pathProjector ())
+          problemSolver ()->initPathProjector ();
+        return problem->pathProjector ();
+      }
+
+      Long Problem::buildAndProjectPaths (const hpp::IDseq& IDedges,
+          const hpp::floatSeqSeq& qbs, const hpp::floatSeqSeq& qes,
+          hpp::Bools_t_out success, hpp::intSeq_out indexesNotProj,
+          hpp::intSeq_out indexesProj, hpp::floatSeq_out coverage)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          std::size_t n = IDedges.length ();
+          if (qbs.length () != n || qes.length () != n)
+            throw std::invalid_argument ("There should be as many initial "
+                "and final configurations as edges.");
+          std::vector <graph::EdgePtr_t> edges (n);
+          // Waypoint edges build their path through several edges.
+          std::vector <char> serial (n, false);
+          for (std::size_t i = 0; i < n; ++i) {
+            edges[i] = HPP_DYNAMIC_PTR_CAST (graph::Edge,
+                graph()->get ((size_t)IDedges[(ULong) i]).lock ());
+            if (!edges[i]) {
+              HPP_THROW (std::invalid_argument, "ID " << IDedges[(ULong) i]
+                  << " is not an edge");
+            }
+            serial[i] = (bool) HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge,
+                edges[i]);
+          }
+          DevicePtr_t robot = getRobotOrThrow (problemSolver());
+          std::vector <Configuration_t> q1s = floatSeqSeqToConfigs
+            (robot, qbs);
+          std::vector <Configuration_t> q2s = floatSeqSeqToConfigs
+            (robot, qes);
+          PathProjectorPtr_t pathProjector = initPathProjector ();
+
+          ThreadPool& pool (server_->threadPool ());
+          reserveDeviceData (robot, pool.size ());
+          std::vector <core::PathPtr_t> paths (n);
+          std::map <graph::Edge*, std::size_t> groupOfEdge;
+          std::vector <std::vector <std::size_t> > groups;
+          for (std::size_t i = 0; i < n; ++i) {
+            if (serial[i]) continue;
+            std::pair <std::map <graph::Edge*, std::size_t>::iterator, bool>
+              res = groupOfEdge.insert (std::make_pair (edges[i].get (),
+                    groups.size ()));
+            if (res.second) {
+              groups.push_back (std::vector <std::size_t> ());
+              // The edges build their constraints lazily, which cannot be
+              // done by several threads at once.
+              edges[i]->configConstraint ();
+              edges[i]->pathConstraint ();
+            }
+            groups[res.first->second].push_back (i);
+          }
+          pool.parallelFor (groups.size (), BuildPaths (edges, groups, q1s,
+                q2s, paths));
+          for (std::size_t i = 0; i < n; ++i) {
+            if (serial[i] && !edges[i]->build (paths[i], q1s[i], q2s[i]))
+              paths[i].reset ();
+          }
+
+          // Each thread projects with its own path projector, created as the
+          // one of the problem, with its own copy of the steering method.
+          std::vector <char> projSucc (n, true);
+          std::vector <core::PathPtr_t> projPaths (n);
+          if (pathProjector) {
+            ProblemSolverPtr_t ps (problemSolver());
+            value_type tolerance;
+            core::PathProjectorBuilder_t createProjector =
+              ps->get <core::PathProjectorBuilder_t>
+              (ps->pathProjectorType (tolerance));
+            ProblemPtr_t problem (ps->problem ());
+            std::vector <PathProjectorPtr_t> projectors (pool.size ());
+            for (std::size_t i = 0; i < projectors.size (); ++i)
+              projectors[i] = createProjector (problem->distance (),
+                  problem->steeringMethod ()->copy (), tolerance);
+            pool.parallelFor (n, ProjectPaths (projectors, paths, projPaths,
+                  projSucc));
+          }
+
+          // Store in order.
+          std::vector <char> succ (n, false);
+          std::vector <Long> notProj (n, -1), proj (n, -1);
+          vector_t cov (vector_t::Zero (n));
+          for (std::size_t i = 0; i < n; ++i) {
+            if (!paths[i]) continue;
+            notProj[i] = storePath (paths[i]);
+
+            core::PathPtr_t projPath (projPaths[i]);
+            bool s = projSucc[i];
+            if (!pathProjector)
+              projPath = (sharePaths () ? paths[i] : paths[i]->copy ());
+            if (!s && (!projPath || projPath->length () == 0)) continue;
+            proj[i] = (projPath == paths[i] && sharePaths () ? notProj[i] :
+                storePath (projPath));
+            succ[i] = s;
+            cov[i] = (paths[i]->length () > 0 ?
+                projPath->length () / paths[i]->length () : 1);
+          }
+
+          success = toBools_t (succ.begin (), succ.end ());
+          indexesNotProj = toIntSeq (notProj.begin (), notProj.end ());
+          indexesProj = toIntSeq (proj.begin (), proj.end ());
+          coverage = vectorToFloatSeq (cov);
+          return (Long) std::count (succ.begin (), succ.end (), true);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      void Problem::setPathRetention (PathRetention retention)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        problemPaths ()->retention = retention;
+      }
+
+      PathRetention Problem::getPathRetention ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        return problemPaths ()->retention;
+      }
+
+      void Problem::setPathStoreCapacity (Long maxPaths, Double maxBytes)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        if (maxPaths < 0 || maxBytes < 0)
+          throw Error ("Bounds of the path store must be positive.");
+        problemPaths ()->store.capacity ((std::size_t) maxPaths,
+            (std::size_t) maxBytes);
+      }
+
+      void Problem::pinStoredPath (Long id, CORBA::Boolean pin)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        try {
+          problemPaths ()->store.pin (id, pin);
+        } catch (const std::exception& exc) {
+          throw hpp::Error (exc.what ());
+        }
+      }
+
+      Long Problem::promoteStoredPath (Long id)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        core::PathVectorPtr_t path = problemPaths ()->store.get (id);
+        if (!path) throw Error ("No path with this id in the store.");
+        Long index = (Long) problemSolver()->paths ().size ();
+        problemSolver()->addPath (path);
+        return index;
+      }
+
+      void Problem::clearPathStore ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        problemPaths ()->store.clear ();
+      }
+
+      void Problem::getPathStoreStats (Long& size, Double& bytes,
+          Long& evicted)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        PathStore& store (problemPaths ()->store);
+        size = (Long) store.size ();
+        bytes = (Double) store.bytes ();
+        evicted = (Long) store.evicted ();
+      }
+
       void Problem::setTargetState (hpp::ID IDstate)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         try {
           graph::GraphComponentPtr_t comp = graph()->get ((size_t)IDstate).lock ();
           graph::StatePtr_t state = HPP_DYNAMIC_PTR_CAST(graph::State, comp);
@@ -544,30 +2298,76 @@ namespace hpp {
       ID Problem::edgeAtParam (UShort pathId, Double param)
         throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
 	try {
 	  if (pathId >= problemSolver()->paths ().size ()) {
             HPP_THROW (Error, "Wrong path id: " << pathId << ", number path: "
 		<< problemSolver()->paths ().size () << ".");
 	  }
-          core::PathVectorPtr_t path = problemSolver()->paths () [pathId];
-          core::PathVectorPtr_t flat = core::PathVector::create(path->outputSize(), path->outputDerivativeSize());
-          path->flatten(flat);
-          value_type unused;
-          std::size_t r = flat->rankAtParam(param, unused);
-          PathPtr_t p = flat->pathAtRank (r);
-          manipulation::ConstraintSetPtr_t constraint = 
-            HPP_DYNAMIC_PTR_CAST (manipulation::ConstraintSet, p->constraints());
-          if (!constraint) {
-            HPP_THROW (Error, "Path constraint is not of the good type "
-                << "at id " << pathId << ", param " << param
-                << " (rank: " << r << ")");
-          }
-          if (!constraint->edge()) {
+          EdgeTimelines::TimelinePtr_t timeline = edgeTimelines_.get
+            (problemSolver()->paths () [pathId]);
+          std::size_t r = timeline->rank (param);
+          if (r >= timeline->edges.size () || timeline->edges[r] < 0) {
             HPP_THROW (Error, "Path constraint does not contain edge information "
                 << "at id " << pathId << ", param " << param
                 << " (rank: " << r << ")");
           }
-          return (ID)constraint->edge()->id();
+          return (ID)timeline->edges[r];
+	}
+	catch (const std::exception& exc) {
+	  throw hpp::Error (exc.what ());
+	}
+      }
+
+      void Problem::setWarmStart (CORBA::Boolean enable, Long size)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        if (size < 0) throw Error ("The size should be positive.");
+        warmStart_.enable (enable, (std::size_t) size);
+      }
+
+      void Problem::getRightHandSideCacheStats (Long& hits, Long& misses,
+          Long& leaves)
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+        hits = (Long) rhsCache_.hits ();
+        misses = (Long) rhsCache_.misses ();
+        leaves = (Long) rhsCache_.leaves ();
+      }
+
+      void Problem::clearRightHandSideCache ()
+        throw (hpp::Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
+        rhsCache_.clear ();
+      }
+
+      void Problem::getEdgeTimeline (UShort pathId, floatSeq_out bounds,
+          IDseq_out edges)
+        throw (Error)
+      {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
+	try {
+	  if (pathId >= problemSolver()->paths ().size ()) {
+            HPP_THROW (Error, "Wrong path id: " << pathId << ", number path: "
+		<< problemSolver()->paths ().size () << ".");
+	  }
+          EdgeTimelines::TimelinePtr_t timeline = edgeTimelines_.get
+            (problemSolver()->paths () [pathId]);
+          const std::vector <value_type>& b (timeline->bounds);
+          floatSeq* bs = new floatSeq ();
+          bs->length ((ULong) b.size ());
+          for (std::size_t i = 0; i < b.size (); ++i)
+            (*bs)[(ULong) i] = b[i];
+          bounds = bs;
+          const std::vector <long>& e (timeline->edges);
+          IDseq* es = new IDseq ();
+          es->length ((ULong) e.size ());
+          for (std::size_t i = 0; i < e.size (); ++i)
+            (*es)[(ULong) i] = (ID) e[i];
+          edges = es;
 	}
 	catch (const std::exception& exc) {
 	  throw hpp::Error (exc.what ());
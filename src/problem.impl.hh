@@ -18,10 +18,23 @@
 #ifndef HPP_MANIPULATION_CORBA_PROBLEM_IMPL_HH
 # define HPP_MANIPULATION_CORBA_PROBLEM_IMPL_HH
 
+# include <list>
+# include <map>
+
+# include <boost/shared_ptr.hpp>
+# include <boost/thread/mutex.hpp>
+
 # include <hpp/corbaserver/manipulation/fwd.hh>
 # include <hpp/manipulation/problem-solver.hh>
 # include "hpp/corbaserver/manipulation/problem.hh"
 
+# include "path-store.hh"
+# include "edge-timelines.hh"
+# include "rhs-cache.hh"
+# include "warm-start.hh"
+# include "projection-profiler.hh"
+# include "job-queue.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace impl {
@@ -29,20 +42,85 @@ namespace hpp {
       using CORBA::UShort;
       using CORBA::ULong;
       using CORBA::Double;
+      using CORBA::Long;
+      using hpp::corbaserver::manipulation::PathRetention;
+      using hpp::corbaserver::manipulation::JobState;
+      using hpp::corbaserver::manipulation::Namess_t;
+      using hpp::corbaserver::manipulation::Rules;
 
       class Problem : public virtual POA_hpp::corbaserver::manipulation::Problem
       {
       public:
 	Problem ();
+        ~Problem ();
         void setServer (Server* server)
         {
           server_ = server;
         }
 
+        /// Use the problem of this name instead of the selected one.
+        void setProblemName (const std::string& name)
+        {
+          problemName_ = name;
+        }
+
         virtual bool selectProblem (const char* name) throw (hpp::Error);
 
         virtual void resetProblem () throw (hpp::Error);
 
+        virtual void cloneProblem (const char* source, const char* target,
+            CORBA::Boolean copyRoadmap) throw (hpp::Error);
+
+        virtual Double solvePortfolio (Long nbInstances,
+            const hpp::intSeq& seeds, Long& pathId, Long& winner,
+            hpp::intSeq_out iterations, hpp::floatSeq_out times)
+          throw (hpp::Error);
+
+        virtual Long submitInitializeGraph () throw (hpp::Error);
+
+        virtual Long submitAutoBuild (const char* graphName,
+            const Names_t& grippers, const Names_t& objects,
+            const Namess_t& handlesPerObject, const Namess_t& shapesPerObject,
+            const Names_t& envNames, const Rules& rulesList)
+          throw (hpp::Error);
+
+        virtual Long submitBuildAndProjectPath (hpp::ID IDedge,
+            const hpp::floatSeq& qb, const hpp::floatSeq& qe)
+          throw (hpp::Error);
+
+        virtual Long submitInsertRobotModel (const char* robotName,
+            const char* rootJointType, const char* packageName,
+            const char* modelName, const char* urdfSuffix,
+            const char* srdfSuffix)
+          throw (hpp::Error);
+
+        virtual Long submitLoadEnvironmentModel (const char* package,
+            const char* envModelName, const char* urdfSuffix,
+            const char* srdfSuffix, const char* prefix)
+          throw (hpp::Error);
+
+        virtual JobState getJobState (Long jobId, Double& elapsed,
+            CORBA::String_out error)
+          throw (hpp::Error);
+
+        virtual CORBA::Boolean cancelJob (Long jobId) throw (hpp::Error);
+
+        virtual intSeq* getJobResult (Long jobId) throw (hpp::Error);
+
+        virtual Long openProblemHandle (const char* name) throw (hpp::Error);
+
+        virtual void closeProblemHandle (Long handle) throw (hpp::Error);
+
+        virtual char* getProblemHandleName (Long handle) throw (hpp::Error);
+
+        virtual void getProblemHandleInterfaces (Long handle,
+            hpp::corbaserver::manipulation::Graph_out graph,
+            hpp::corbaserver::manipulation::Problem_out problem,
+            hpp::corbaserver::manipulation::Robot_out robot)
+          throw (hpp::Error);
+
+        virtual Double solve (Long handle, Long& pathId) throw (hpp::Error);
+
         virtual Names_t* getAvailable (const char* what) throw (hpp::Error);
 
         virtual void createGrasp (const char* graspName,
@@ -84,11 +162,43 @@ namespace hpp {
             hpp::floatSeq_out output, double& residualError)
           throw (hpp::Error);
 
+        virtual Long applyConstraintsBatch (hpp::ID id,
+            const hpp::floatSeqSeq& inputs, hpp::floatSeqSeq_out outputs,
+            hpp::Bools_t_out success, hpp::floatSeq_out residualErrors)
+          throw (hpp::Error);
+
+        virtual void benchmarkProjection (hpp::ID id,
+            const hpp::floatSeqSeq& inputs, hpp::floatSeq_out times,
+            hpp::intSeq_out nbSuccess)
+          throw (hpp::Error);
+
+        virtual Long isConfigValidBatch (const hpp::floatSeqSeq& configs,
+            CORBA::Boolean withCollisionPairs, hpp::Bools_t_out valid,
+            hpp::Names_t_out objects1, hpp::Names_t_out objects2)
+          throw (hpp::Error);
+
+        virtual Long sampleStateConfigurations (hpp::ID stateId, Long count,
+            Long maxAttempts, hpp::floatSeqSeq_out configs,
+            Double& acceptanceRate, hpp::floatSeq_out phaseTimes)
+          throw (hpp::Error);
+
         virtual bool applyConstraintsWithOffset (hpp::ID IDedge,
             const hpp::floatSeq& qnear, const hpp::floatSeq& input,
             hpp::floatSeq_out output, double& residualError)
           throw (hpp::Error);
 
+        virtual Long probeOutgoingEdges (const hpp::floatSeq& q1,
+            const hpp::floatSeq& q2, hpp::ID& stateId, hpp::IDseq_out edgeIds,
+            hpp::floatSeqSeq_out outputs, hpp::Bools_t_out success,
+            hpp::floatSeq_out residualErrors)
+          throw (hpp::Error);
+
+        virtual Long generateTargetConfigs (hpp::ID IDedge,
+            const hpp::floatSeqSeq& qfroms, const hpp::floatSeqSeq& inputs,
+            hpp::floatSeqSeq_out outputs, hpp::Bools_t_out success,
+            hpp::floatSeq_out residualErrors, hpp::intSeq_out leaves)
+          throw (hpp::Error);
+
         virtual bool buildAndProjectPath (hpp::ID IDedge,
             const hpp::floatSeq& qb,
             const hpp::floatSeq& qe,
@@ -96,15 +206,123 @@ namespace hpp {
             CORBA::Long& indexProj)
           throw (hpp::Error);
 
+        virtual Long buildAndProjectPaths (const hpp::IDseq& IDedges,
+            const hpp::floatSeqSeq& qbs, const hpp::floatSeqSeq& qes,
+            hpp::Bools_t_out success, hpp::intSeq_out indexesNotProj,
+            hpp::intSeq_out indexesProj, hpp::floatSeq_out coverage)
+          throw (hpp::Error);
+
+        virtual void setPathRetention (PathRetention retention)
+          throw (hpp::Error);
+
+        virtual PathRetention getPathRetention ()
+          throw (hpp::Error);
+
+        virtual void setPathStoreCapacity (Long maxPaths, Double maxBytes)
+          throw (hpp::Error);
+
+        virtual void pinStoredPath (Long id, CORBA::Boolean pin)
+          throw (hpp::Error);
+
+        virtual Long promoteStoredPath (Long id)
+          throw (hpp::Error);
+
+        virtual void clearPathStore ()
+          throw (hpp::Error);
+
+        virtual void getPathStoreStats (Long& size, Double& bytes,
+            Long& evicted)
+          throw (hpp::Error);
+
         virtual void setTargetState (hpp::ID IDstate);
 
         virtual ID edgeAtParam (UShort pathId, Double param)
           throw (Error);
 
+        virtual void setWarmStart (CORBA::Boolean enable, Long size)
+          throw (hpp::Error);
+
+        virtual void getRightHandSideCacheStats (Long& hits, Long& misses,
+            Long& leaves)
+          throw (hpp::Error);
+
+        virtual void clearRightHandSideCache ()
+          throw (hpp::Error);
+
+        virtual void getEdgeTimeline (UShort pathId, floatSeq_out bounds,
+            IDseq_out edges)
+          throw (Error);
+
       private:
+        /// A problem handle and the servants bound to its problem.
+        struct ProblemHandle;
+        typedef boost::shared_ptr <ProblemHandle> ProblemHandlePtr_t;
+        /// The path retention and the path store of a problem solver.
+        struct ProblemPaths
+        {
+          ProblemPaths ();
+          PathRetention retention;
+          PathStore store;
+        }; // struct ProblemPaths
+        typedef boost::shared_ptr <ProblemPaths> ProblemPathsPtr_t;
+
         ProblemSolverPtr_t problemSolver();
         graph::GraphPtr_t graph(bool throwIfNull = true);
+        /// \throw std::invalid_argument if the handle is not open.
+        ProblemHandlePtr_t problemHandle (Long handle);
+        /// Get the constraint of a state or an edge, ready to be applied.
+        ConstraintSetPtr_t configConstraint (hpp::ID id);
+        /// Initialize the steering method and the path projector if needed.
+        /// \return the path projector, possibly null.
+        PathProjectorPtr_t initPathProjector ();
+        /// Get the paths of the problem solver locked by the request,
+        /// creating them if needed.
+        /// \note The problem solver must be locked.
+        ProblemPathsPtr_t problemPaths ();
+        /// Drop the paths of a problem, before its problem solver is
+        /// deleted or created.
+        void dropProblemPaths (const std::string& name);
+        /// Whether a projected path identical to the built path is kept
+        /// once, according to the path retention.
+        bool sharePaths ();
+        /// Keep a path according to the path retention.
+        /// \return its index in the ProblemSolver or in the path store.
+        Long storePath (const core::PathPtr_t& path);
+        /// Submit a job run with the selected problem.
+        Long submitJob (const JobQueue::Task_t& task);
+        /// Keep the problem solver of the planner that found the paths of
+        /// solvePortfolio while one of them remains, and delete those
+        /// whose paths were all erased.
+        /// \note Only called on the main servant.
+        void keepPortfolioWinner (const ProblemSolverPtr_t& winner,
+            const core::PathVectors_t& paths);
+
         Server* server_;
+        /// Name of the problem used by the requests, if not the selected
+        /// one.
+        std::string problemName_;
+        /// Paths of the problem solvers, by problem name. Only the
+        /// servant of the selected problem holds them, so that the handles
+        /// of a problem and its selection share them.
+        typedef std::map <std::string,
+                std::pair <ProblemSolverPtr_t, ProblemPathsPtr_t> >
+                  ProblemPathsMap_t;
+        ProblemPathsMap_t problemPaths_;
+        boost::mutex problemPathsMutex_;
+        EdgeTimelines edgeTimelines_;
+        RightHandSideCache rhsCache_;
+        WarmStartStore warmStart_;
+        /// Open handles. Only the servant of the selected problem holds
+        /// them.
+        std::map <Long, ProblemHandlePtr_t> handles_;
+        Long nextHandle_;
+        boost::mutex handlesMutex_;
+        /// Problem solvers of the planners that won a portfolio, with the
+        /// solutions, which refer to their constraint graph.
+        typedef std::list <std::pair <ProblemSolverPtr_t,
+                std::vector <core::PathVectorWkPtr_t> > > PortfolioWinners_t;
+        PortfolioWinners_t portfolioWinners_;
+        boost::mutex portfolioMutex_;
       }; // class Problem
     } // namespace impl
   } // namespace manipulation
@@ -0,0 +1,119 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "projection-profiler.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      namespace {
+        std::vector <value_type> decades (int from, int to)
+        {
+          std::vector <value_type> bounds;
+          for (int i = from; i <= to; ++i)
+            bounds.push_back (std::pow (10., i));
+          return bounds;
+        }
+
+        std::size_t bin (const std::vector <value_type>& bounds,
+            value_type value)
+        {
+          return std::upper_bound (bounds.begin (), bounds.end (), value)
+            - bounds.begin ();
+        }
+      }
+
+      ProjectionProfiler::Profile::Profile () :
+        nbApply (0), nbSuccess (0), totalTime (0), maxTime (0),
+        nbWarmStart (0), nbWarmStartSuccess (0), warmStartTime (0),
+        timeHistogram (timeBounds ().size () + 1, 0),
+        residualHistogram (residualBounds ().size () + 1, 0)
+      {}
+
+      void ProjectionProfiler::Profile::add (value_type time, bool success,
+          value_type residual)
+      {
+        ++nbApply;
+        if (success) ++nbSuccess;
+        totalTime += time;
+        maxTime = std::max (maxTime, time);
+        ++timeHistogram [bin (timeBounds (), time)];
+        ++residualHistogram [bin (residualBounds (), residual)];
+      }
+
+      void ProjectionProfiler::Profile::addWarmStart (value_type time,
+          bool success)
+      {
+        ++nbWarmStart;
+        if (success) ++nbWarmStartSuccess;
+        warmStartTime += time;
+      }
+
+      void ProjectionProfiler::Profile::merge (const Profile& other)
+      {
+        nbApply += other.nbApply;
+        nbSuccess += other.nbSuccess;
+        totalTime += other.totalTime;
+        maxTime = std::max (maxTime, other.maxTime);
+        nbWarmStart += other.nbWarmStart;
+        nbWarmStartSuccess += other.nbWarmStartSuccess;
+        warmStartTime += other.warmStartTime;
+        for (std::size_t i = 0; i < timeHistogram.size (); ++i)
+          timeHistogram[i] += other.timeHistogram[i];
+        for (std::size_t i = 0; i < residualHistogram.size (); ++i)
+          residualHistogram[i] += other.residualHistogram[i];
+      }
+
+      const std::vector <value_type>& ProjectionProfiler::timeBounds ()
+      {
+        // From 1 microsecond to 1 second.
+        static const std::vector <value_type> bounds (decades (-6, 0));
+        return bounds;
+      }
+
+      const std::vector <value_type>& ProjectionProfiler::residualBounds ()
+      {
+        static const std::vector <value_type> bounds (decades (-12, 0));
+        return bounds;
+      }
+
+      void ProjectionProfiler::record (const graph::GraphPtr_t& graph,
+          std::size_t id, const Profile& profile)
+      {
+        if (profile.nbApply == 0) return;
+        boost::mutex::scoped_lock lock (mutex_);
+        profiles_.get (graph)[id].merge (profile);
+      }
+
+      ProjectionProfiler::Profiles_t ProjectionProfiler::profiles
+      (const graph::GraphPtr_t& graph)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return profiles_.get (graph);
+      }
+
+      void ProjectionProfiler::reset (const graph::GraphPtr_t& graph)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        profiles_.get (graph).clear ();
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
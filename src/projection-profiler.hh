@@ -0,0 +1,89 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_PROJECTION_PROFILER_HH
+# define HPP_MANIPULATION_CORBA_PROJECTION_PROFILER_HH
+
+# include <map>
+# include <vector>
+
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/graph/fwd.hh>
+
+# include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Statistics of the projections done by the servants, per constraint
+      /// graph and per graph component.
+      ///
+      /// The statistics of a graph are dropped when the graph is deleted.
+      class ProjectionProfiler
+      {
+        public:
+          struct Profile
+          {
+            Profile ();
+
+            /// Add one projection.
+            void add (value_type time, bool success, value_type residual);
+            /// Count a projection, already added, as started from a
+            /// previous solution.
+            /// \param success whether it converged from this solution.
+            void addWarmStart (value_type time, bool success);
+            void merge (const Profile& other);
+
+            std::size_t nbApply, nbSuccess;
+            value_type totalTime, maxTime;
+            std::size_t nbWarmStart, nbWarmStartSuccess;
+            value_type warmStartTime;
+            /// Number of projections per bin of timeBounds ().
+            std::vector <std::size_t> timeHistogram;
+            /// Number of projections per bin of residualBounds ().
+            std::vector <std::size_t> residualHistogram;
+          }; // struct Profile
+          typedef std::map <std::size_t, Profile> Profiles_t;
+
+          /// Upper bounds of the bins of the time histogram, in seconds.
+          /// The last bin has no upper bound.
+          static const std::vector <value_type>& timeBounds ();
+          /// Upper bounds of the bins of the residual histogram.
+          /// The last bin has no upper bound.
+          static const std::vector <value_type>& residualBounds ();
+
+          /// Add projections of component id of graph.
+          void record (const graph::GraphPtr_t& graph, std::size_t id,
+              const Profile& profile);
+
+          /// Get the profiles of graph.
+          Profiles_t profiles (const graph::GraphPtr_t& graph);
+
+          /// Clear the profiles of graph.
+          void reset (const graph::GraphPtr_t& graph);
+
+        private:
+          WeakPtrMap <graph::Graph, Profiles_t> profiles_;
+          boost::mutex mutex_;
+      }; // class ProjectionProfiler
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_PROJECTION_PROFILER_HH
@@ -0,0 +1,106 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "rhs-cache.hh"
+
+#include <hpp/core/config-projector.hh>
+
+#include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      RightHandSideCache::RightHandSideCache (std::size_t maxLeaves) :
+        maxLeaves_ (maxLeaves), hits_ (0), misses_ (0)
+      {}
+
+      bool RightHandSideCache::rightHandSideFromConfig
+      (const core::ConfigProjectorPtr_t& cp, core::ConfigurationIn_t q)
+      {
+        core::vector_t key;
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          Entries_t::iterator it = entries_.find (cp.get ());
+          if (it == entries_.end () || it->second.projector.lock () != cp) {
+            // New projector, or another one at the same address.
+            Entries_t::iterator e = entries_.begin ();
+            while (e != entries_.end ()) {
+              if (e->second.projector.expired ()) entries_.erase (e++);
+              else ++e;
+            }
+            Entry& entry = entries_[cp.get ()];
+            entry.projector = cp;
+            entry.coordinates = constrainedCoordinates (cp, true);
+            entry.leaves.clear ();
+            it = entries_.find (cp.get ());
+          }
+          const std::vector <core::size_type>& coords
+            (it->second.coordinates);
+          key.resize (coords.size ());
+          for (std::size_t i = 0; i < coords.size (); ++i)
+            key[i] = q[coords[i]];
+          Leaves_t::const_iterator leaf = it->second.leaves.find (key);
+          if (leaf != it->second.leaves.end ()) {
+            ++hits_;
+            cp->rightHandSide (leaf->second);
+            return true;
+          }
+          ++misses_;
+        }
+
+        cp->rightHandSideFromConfig (q);
+
+        boost::mutex::scoped_lock lock (mutex_);
+        Entries_t::iterator it = entries_.find (cp.get ());
+        if (it == entries_.end ()) return false;
+        if (it->second.leaves.size () >= maxLeaves_)
+          it->second.leaves.clear ();
+        it->second.leaves[key] = cp->rightHandSide ();
+        return false;
+      }
+
+      void RightHandSideCache::clear ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        entries_.clear ();
+        hits_ = misses_ = 0;
+      }
+
+      std::size_t RightHandSideCache::hits ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return hits_;
+      }
+
+      std::size_t RightHandSideCache::misses ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return misses_;
+      }
+
+      std::size_t RightHandSideCache::leaves ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        std::size_t res = 0;
+        for (Entries_t::const_iterator it = entries_.begin ();
+            it != entries_.end (); ++it)
+          res += it->second.leaves.size ();
+        return res;
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
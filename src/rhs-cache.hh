@@ -0,0 +1,88 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_RHS_CACHE_HH
+# define HPP_MANIPULATION_CORBA_RHS_CACHE_HH
+
+# include <algorithm>
+# include <map>
+# include <vector>
+
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/core/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Lexicographic order, to use vectors as keys.
+      struct VectorLess
+      {
+        bool operator() (const core::vector_t& a, const core::vector_t& b)
+          const
+        {
+          if (a.size () != b.size ()) return a.size () < b.size ();
+          return std::lexicographical_compare (a.data (),
+              a.data () + a.size (), b.data (), b.data () + b.size ());
+        }
+      }; // struct VectorLess
+
+      /// Right hand sides of config projectors, per leaf of the foliation.
+      ///
+      /// The leaf of a configuration is identified by the coordinates that
+      /// the constraints with non constant right hand side depend on. When
+      /// a right hand side is requested for a leaf that was already
+      /// visited, it is set without evaluating the constraints.
+      class RightHandSideCache
+      {
+        public:
+          /// \param maxLeaves maximal number of leaves per projector. When
+          ///        exceeded, the leaves of the projector are forgotten.
+          RightHandSideCache (std::size_t maxLeaves = 1000);
+
+          /// Same as core::ConfigProjector::rightHandSideFromConfig.
+          /// \return whether the leaf was found in the cache.
+          bool rightHandSideFromConfig (const core::ConfigProjectorPtr_t& cp,
+              core::ConfigurationIn_t q);
+
+          void clear ();
+
+          std::size_t hits ();
+          std::size_t misses ();
+          /// Number of leaves in the cache.
+          std::size_t leaves ();
+
+        private:
+          typedef std::map <core::vector_t, core::vector_t, VectorLess>
+            Leaves_t;
+          struct Entry {
+            core::ConfigProjectorWkPtr_t projector;
+            /// Coordinates defining the leaf.
+            std::vector <core::size_type> coordinates;
+            Leaves_t leaves;
+          };
+          typedef std::map <const core::ConfigProjector*, Entry> Entries_t;
+
+          Entries_t entries_;
+          std::size_t maxLeaves_, hits_, misses_;
+          boost::mutex mutex_;
+      }; // class RightHandSideCache
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_RHS_CACHE_HH
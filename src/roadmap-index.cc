@@ -0,0 +1,151 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "roadmap-index.hh"
+
+#include <map>
+
+#include <boost/functional/hash.hpp>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/node.hh>
+#include <hpp/core/roadmap.hh>
+#include <hpp/core/connected-component.hh>
+
+#include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/graph/state.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      std::size_t RoadmapIndex::frequencies (const core::RoadmapPtr_t& roadmap,
+          const graph::StatePtr_t& state, std::vector <std::size_t>& freqs)
+      {
+        const core::ConnectedComponents_t& ccs = roadmap->connectedComponents();
+        std::map <core::ConnectedComponent*, std::size_t> ccIndex;
+        std::size_t i = 0;
+        for (core::ConnectedComponents_t::const_iterator _cc = ccs.begin();
+            _cc != ccs.end(); ++_cc, ++i)
+          ccIndex [_cc->get()] = i;
+        freqs.assign (ccs.size(), 0);
+
+        IndexPtr_t index (select (roadmap));
+        boost::mutex::scoped_lock lock (index->mutex);
+        index->update (roadmap);
+        if (state->id () >= index->states.size ()) return 0;
+        const std::vector <core::NodePtr_t>& nodes =
+          index->states[state->id ()];
+        for (std::size_t j = 0; j < nodes.size (); ++j)
+          ++freqs [ccIndex [nodes[j]->connectedComponent().get()]];
+        return nodes.size ();
+      }
+
+      core::NodePtr_t RoadmapIndex::find (const core::RoadmapPtr_t& roadmap,
+          const Configuration_t& q)
+      {
+        IndexPtr_t index (select (roadmap));
+        boost::mutex::scoped_lock lock (index->mutex);
+        index->update (roadmap);
+        std::pair <ConfigMap_t::const_iterator, ConfigMap_t::const_iterator>
+          range = index->configs.equal_range (hash (q));
+        for (ConfigMap_t::const_iterator _n = range.first; _n != range.second;
+            ++_n) {
+          const Configuration_t& other = *_n->second->configuration ();
+          if (other.size () == q.size () && other == q) return _n->second;
+        }
+        return NULL;
+      }
+
+      RoadmapIndex::IndexPtr_t RoadmapIndex::select
+      (const core::RoadmapPtr_t& roadmap)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        IndexPtr_t& index (indexes_.get (roadmap));
+        if (!index) index.reset (new Index ());
+        return index;
+      }
+
+      RoadmapIndex::Index::Index () : size (0)
+      {}
+
+      void RoadmapIndex::Index::update (const core::RoadmapPtr_t& roadmap)
+      {
+        // The nodes are only appended to the roadmap until it is cleared,
+        // so last is valid unless it was.
+        const core::Nodes_t& nodes = roadmap->nodes ();
+        if (nodes.size () < size || cleared (roadmap))
+          clear ();
+        if (nodes.size () == size) return;
+
+        core::Nodes_t::const_iterator _n;
+        if (size == 0) _n = nodes.begin ();
+        else {
+          _n = last;
+          ++_n;
+        }
+        for (; _n != nodes.end (); ++_n) {
+          configs.insert (std::make_pair (hash (*(*_n)->configuration ()),
+                *_n));
+          RoadmapNodePtr_t node = dynamic_cast <RoadmapNodePtr_t> (*_n);
+          graph::StatePtr_t state;
+          if (node) state = node->graphState ();
+          if (state) {
+            if (state->id () >= states.size ())
+              states.resize (state->id () + 1);
+            states[state->id ()].push_back (*_n);
+          }
+          last = _n;
+          ++size;
+        }
+        const core::ConnectedComponents_t& ccs =
+          roadmap->connectedComponents ();
+        components.clear ();
+        components.insert (ccs.begin (), ccs.end ());
+      }
+
+      bool RoadmapIndex::Index::cleared (const core::RoadmapPtr_t& roadmap)
+        const
+      {
+        if (size == 0) return false;
+        // The components merged since the last update are not in the
+        // roadmap anymore, but the others are, unless it was cleared. If all
+        // of them were merged into new ones, the index is rebuilt for
+        // nothing.
+        const core::ConnectedComponents_t& ccs =
+          roadmap->connectedComponents ();
+        for (core::ConnectedComponents_t::const_iterator _cc = ccs.begin ();
+            _cc != ccs.end (); ++_cc)
+          if (components.count (*_cc)) return false;
+        return true;
+      }
+
+      void RoadmapIndex::Index::clear ()
+      {
+        size = 0;
+        states.clear ();
+        configs.clear ();
+        components.clear ();
+      }
+
+      std::size_t RoadmapIndex::hash (const Configuration_t& q)
+      {
+        return boost::hash_range (q.data (), q.data () + q.size ());
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,104 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_ROADMAP_INDEX_HH
+# define HPP_MANIPULATION_CORBA_ROADMAP_INDEX_HH
+
+# include <set>
+# include <vector>
+
+# include <boost/shared_ptr.hpp>
+# include <boost/unordered_map.hpp>
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/core/fwd.hh>
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/graph/fwd.hh>
+
+# include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Index of the roadmap nodes by graph state and by configuration.
+      ///
+      /// Each roadmap has its own index, dropped when the roadmap is
+      /// deleted. The nodes are indexed incrementally: each query first
+      /// indexes the nodes added to the roadmap since the previous query. The
+      /// index of a roadmap is rebuilt when the roadmap is cleared.
+      class RoadmapIndex
+      {
+        public:
+          /// Count the nodes of a state in each connected component.
+          /// \param freqs filled with one value per connected component of
+          ///        roadmap, in the order of Roadmap::connectedComponents.
+          /// \return the number of nodes of the state.
+          std::size_t frequencies (const core::RoadmapPtr_t& roadmap,
+              const graph::StatePtr_t& state,
+              std::vector <std::size_t>& freqs);
+
+          /// Find the node whose configuration is exactly q.
+          /// \return the node or NULL if there is none.
+          core::NodePtr_t find (const core::RoadmapPtr_t& roadmap,
+              const Configuration_t& q);
+
+        private:
+          typedef boost::unordered_multimap <std::size_t, core::NodePtr_t>
+            ConfigMap_t;
+
+          /// Index of the nodes of one roadmap.
+          struct Index
+          {
+            Index ();
+
+            /// Index the new nodes of roadmap.
+            /// \note mutex must be locked.
+            void update (const core::RoadmapPtr_t& roadmap);
+            /// Whether roadmap was cleared since the last update.
+            bool cleared (const core::RoadmapPtr_t& roadmap) const;
+            void clear ();
+
+            /// Number of indexed nodes and last of them.
+            std::size_t size;
+            core::Nodes_t::const_iterator last;
+            /// Connected components of the roadmap at the last update.
+            /// Clearing the roadmap removes all of them, and holding them
+            /// prevents the new components from reusing their address,
+            /// unlike the nodes.
+            std::set <core::ConnectedComponentPtr_t> components;
+
+            /// Nodes of each state, indexed by state id.
+            std::vector <std::vector <core::NodePtr_t> > states;
+            ConfigMap_t configs;
+            boost::mutex mutex;
+          }; // struct Index
+          typedef boost::shared_ptr <Index> IndexPtr_t;
+
+          /// Get the index of roadmap, and drop those of the deleted
+          /// roadmaps.
+          IndexPtr_t select (const core::RoadmapPtr_t& roadmap);
+
+          static std::size_t hash (const Configuration_t& q);
+
+          WeakPtrMap <core::Roadmap, IndexPtr_t> indexes_;
+          boost::mutex mutex_;
+      }; // class RoadmapIndex
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_ROADMAP_INDEX_HH
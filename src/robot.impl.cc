@@ -34,6 +34,7 @@
 #include <hpp/corbaserver/manipulation/server.hh>
 
 #include "tools.hh"
+#include "problem-locks.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -123,6 +124,7 @@ namespace hpp {
       void Robot::create (const char* name)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           problemSolver()->robot (createRobot (std::string (name)));
 	} catch (const std::exception& exc) {
@@ -136,6 +138,7 @@ namespace hpp {
           const char* srdfSuffix)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
           if (robot->has<FrameIndices_t> (robotName))
@@ -157,6 +160,7 @@ namespace hpp {
               const char* srdfString)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
           if (robot->has<FrameIndices_t> (robotName))
@@ -177,6 +181,7 @@ namespace hpp {
           const char* srdfSuffix)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
 	  srdf::addRobotSRDFModel (robot, std::string (robotName),
@@ -195,6 +200,7 @@ namespace hpp {
           const char* srdfSuffix)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
           if (robot->has<FrameIndices_t> (objectName))
@@ -216,6 +222,7 @@ namespace hpp {
           const char* srdfSuffix)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
           if (robot->has<FrameIndices_t> (robotName))
@@ -237,6 +244,7 @@ namespace hpp {
           const char* srdfString)
 	throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getOrCreateRobot (problemSolver());
           if (robot->has<FrameIndices_t> (robotName))
@@ -257,6 +265,7 @@ namespace hpp {
           const char* srdfSuffix, const char* prefix)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 
@@ -311,6 +320,7 @@ namespace hpp {
           const char* srdfString, const char* prefix)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 
@@ -363,6 +373,7 @@ namespace hpp {
       Transform__slice* Robot::getRootJointPosition (const char* robotName)
         throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
         try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
           std::string n (robotName);
@@ -388,6 +399,7 @@ namespace hpp {
                                         const ::hpp::Transform_ position)
         throw (Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
         try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
           std::string n (robotName);
@@ -404,6 +416,7 @@ namespace hpp {
           const ::hpp::Transform_ localPosition)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  JointPtr_t joint =
@@ -421,6 +434,7 @@ namespace hpp {
           const ::hpp::Transform_ p)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  JointPtr_t joint =
@@ -444,6 +458,7 @@ namespace hpp {
           const ::hpp::Transform_ localPosition)
 	throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Write, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
 	  JointPtr_t joint =
@@ -462,6 +477,7 @@ namespace hpp {
           ::hpp::Transform__out position)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
           GripperPtr_t gripper = robot->get <GripperPtr_t> (gripperName);
@@ -481,6 +497,7 @@ namespace hpp {
           ::hpp::Transform__out position)
         throw (hpp::Error)
       {
+        ProblemLocks::Lock lock (server_, ProblemLocks::Read, problemName_);
 	try {
           DevicePtr_t robot = getRobotOrThrow (problemSolver());
           HandlePtr_t handle = robot->get <HandlePtr_t> (handleName);
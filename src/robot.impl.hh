@@ -37,6 +37,12 @@ namespace hpp {
             server_ = server;
           }
 
+          /// Use the problem of this name instead of the selected one.
+          void setProblemName (const std::string& name)
+          {
+            problemName_ = name;
+          }
+
           virtual void create (const char* robotName)
             throw (hpp::Error);
 
@@ -114,6 +120,9 @@ namespace hpp {
         private:
           ProblemSolverPtr_t problemSolver();
           Server* server_;
+          /// Name of the problem used by the requests, if not the selected
+          /// one.
+          std::string problemName_;
       }; // class Robot
     } // namespace impl
   } // namespace manipulation
@@ -22,6 +22,11 @@
 #include "graph.impl.hh"
 #include "problem.impl.hh"
 #include "robot.impl.hh"
+#include "thread-pool.hh"
+#include "roadmap-index.hh"
+#include "projection-profiler.hh"
+#include "problem-locks.hh"
+#include "job-queue.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -32,7 +37,12 @@ namespace hpp {
       problemImpl_ (new corba::Server <impl::Problem>
 		    (argc, argv, multiThread, poaName)),
       robotImpl_ (new corba::Server <impl::Robot>
-		  (argc, argv, multiThread, poaName))
+		  (argc, argv, multiThread, poaName)),
+      threadPool_ (new impl::ThreadPool ()),
+      roadmapIndex_ (new impl::RoadmapIndex ()),
+      projectionProfiler_ (new impl::ProjectionProfiler ()),
+      problemLocks_ (new impl::ProblemLocks ()),
+      jobQueue_ (new impl::JobQueue ())
     {
       graphImpl_->implementation ().setServer (this);
       problemImpl_->implementation ().setServer (this);
@@ -41,9 +51,15 @@ namespace hpp {
 
     Server::~Server () 
     {
+      // Running jobs use the servants.
+      delete jobQueue_;
       delete graphImpl_;
       delete problemImpl_;
       delete robotImpl_;
+      delete threadPool_;
+      delete roadmapIndex_;
+      delete projectionProfiler_;
+      delete problemLocks_;
     }
 
     /// Start corba server
@@ -71,6 +87,13 @@ namespace hpp {
     ProblemSolverPtr_t Server::problemSolver ()
         throw (std::logic_error)
     {
+      if (const impl::ProblemLocks::Binding* binding =
+          problemLocks_->bound ()) {
+        if (binding->problemSolver == NULL)
+          throw std::logic_error ("No manipulation problem named "
+              + binding->name);
+        return binding->problemSolver;
+      }
       ProblemSolverPtr_t psm = dynamic_cast <ProblemSolverPtr_t>
         (problemSolverMap_->selected());
       if (psm == NULL)
@@ -83,5 +106,45 @@ namespace hpp {
       return problemSolverMap_;
     }
 
+    impl::Graph& Server::graph ()
+    {
+      return graphImpl_->implementation ();
+    }
+
+    impl::Problem& Server::problem ()
+    {
+      return problemImpl_->implementation ();
+    }
+
+    impl::Robot& Server::robot ()
+    {
+      return robotImpl_->implementation ();
+    }
+
+    impl::ThreadPool& Server::threadPool ()
+    {
+      return *threadPool_;
+    }
+
+    impl::RoadmapIndex& Server::roadmapIndex ()
+    {
+      return *roadmapIndex_;
+    }
+
+    impl::ProjectionProfiler& Server::projectionProfiler ()
+    {
+      return *projectionProfiler_;
+    }
+
+    impl::ProblemLocks& Server::problemLocks ()
+    {
+      return *problemLocks_;
+    }
+
+    impl::JobQueue& Server::jobQueue ()
+    {
+      return *jobQueue_;
+    }
+
   } // namespace manipulation
 } // namespace hpp
@@ -0,0 +1,128 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "thread-pool.hh"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      struct ThreadPool::Batch
+      {
+        Batch (std::size_t n, const Task_t& t, std::size_t nbSlots) :
+          task (t), size (n), next (0),
+          chunk (std::max <std::size_t> (1, n / (8 * nbSlots))),
+          running (nbSlots)
+        {}
+
+        /// Get the next range of items to process.
+        bool take (std::size_t& begin, std::size_t& end)
+        {
+          boost::mutex::scoped_lock lock (mutex);
+          if (next >= size) return false;
+          begin = next;
+          end = std::min (size, next + chunk);
+          next = end;
+          return true;
+        }
+
+        /// Keep the first exception thrown by a task.
+        void fail (const boost::exception_ptr& e)
+        {
+          boost::mutex::scoped_lock lock (mutex);
+          if (!error) error = e;
+        }
+
+        void run (std::size_t worker)
+        {
+          std::size_t begin, end;
+          while (take (begin, end)) {
+            for (std::size_t i = begin; i < end; ++i) {
+              try {
+                task (i, worker);
+              } catch (...) {
+                fail (boost::current_exception ());
+              }
+            }
+          }
+          boost::mutex::scoped_lock lock (mutex);
+          if (--running == 0) done.notify_all ();
+        }
+
+        Task_t task;
+        std::size_t size, next, chunk, running;
+        boost::exception_ptr error;
+        boost::mutex mutex;
+        boost::condition_variable done;
+      }; // struct Batch
+
+      ThreadPool::ThreadPool (std::size_t nbThreads) :
+        size_ (nbThreads), stop_ (false)
+      {
+        if (size_ == 0) size_ = boost::thread::hardware_concurrency ();
+        if (size_ == 0) size_ = 1;
+        for (std::size_t i = 0; i < size_; ++i)
+          workers_.create_thread (boost::bind (&ThreadPool::work, this, i));
+      }
+
+      ThreadPool::~ThreadPool ()
+      {
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          stop_ = true;
+        }
+        condition_.notify_all ();
+        workers_.join_all ();
+      }
+
+      void ThreadPool::parallelFor (std::size_t n, const Task_t& task)
+      {
+        if (n == 0) return;
+        std::size_t nbSlots = std::min (n, size_);
+        Batch batch (n, task, nbSlots);
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          for (std::size_t i = 0; i < nbSlots; ++i) queue_.push_back (&batch);
+        }
+        condition_.notify_all ();
+
+        boost::mutex::scoped_lock lock (batch.mutex);
+        while (batch.running > 0) batch.done.wait (lock);
+        if (batch.error) boost::rethrow_exception (batch.error);
+      }
+
+      void ThreadPool::work (std::size_t index)
+      {
+        while (true) {
+          Batch* batch;
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            while (!stop_ && queue_.empty ()) condition_.wait (lock);
+            if (queue_.empty ()) return;
+            batch = queue_.front ();
+            queue_.pop_front ();
+          }
+          batch->run (index);
+        }
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,80 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_THREAD_POOL_HH
+# define HPP_MANIPULATION_CORBA_THREAD_POOL_HH
+
+# include <deque>
+
+# include <boost/function.hpp>
+# include <boost/thread/thread.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/thread/condition_variable.hpp>
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Set of worker threads shared by the servants.
+      ///
+      /// Requests that process many independent items (configurations,
+      /// graph components...) give them to ThreadPool::parallelFor, which
+      /// returns when every item has been processed.
+      class ThreadPool
+      {
+        public:
+          /// Function called with the item index and the worker index.
+          typedef boost::function <void (std::size_t, std::size_t)> Task_t;
+
+          /// \param nbThreads number of workers. If 0, one worker per core
+          ///        is created.
+          ThreadPool (std::size_t nbThreads = 0);
+
+          ~ThreadPool ();
+
+          /// Number of workers.
+          std::size_t size () const
+          {
+            return size_;
+          }
+
+          /// Call task (i, w) for each i in [0, n).
+          ///
+          /// w is the index of the worker executing the task, in
+          /// [0, size ()). Two tasks with the same worker index never run
+          /// concurrently so it can be used to index per-thread data.
+          /// \throw the first exception thrown by a task, unchanged. The
+          ///        remaining items are processed anyway.
+          /// \warning must not be called from a task.
+          void parallelFor (std::size_t n, const Task_t& task);
+
+        private:
+          struct Batch;
+
+          void work (std::size_t index);
+
+          std::size_t size_;
+          boost::thread_group workers_;
+          std::deque <Batch*> queue_;
+          boost::mutex mutex_;
+          boost::condition_variable condition_;
+          bool stop_;
+      }; // class ThreadPool
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_THREAD_POOL_HH
@@ -16,6 +16,17 @@
 
 #include "tools.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <hpp/util/pointer.hh>
+#include <hpp/constraints/differentiable-function.hh>
+#include <hpp/core/config-projector.hh>
+#include <hpp/core/locked-joint.hh>
+#include <hpp/core/numerical-constraint.hh>
+#include <hpp/manipulation/device.hh>
+#include <hpp/manipulation/constraint-set.hh>
+
 namespace hpp {
   DevicePtr_t getRobotOrThrow (ProblemSolverPtr_t p)
   {
@@ -23,4 +34,78 @@ namespace hpp {
     if (!robot) throw Error ("Robot not found.");
     return robot;
   }
+
+  ConstraintSetPtr_t copyConstraintSet (const ConstraintSetPtr_t& c)
+  {
+    ConstraintSetPtr_t res =
+      HPP_DYNAMIC_PTR_CAST (manipulation::ConstraintSet, c->copy ());
+    if (!res) throw std::runtime_error ("Could not copy the constraint set.");
+    return res;
+  }
+
+  std::vector <core::size_type> constrainedCoordinates
+  (const core::ConfigProjectorPtr_t& cp, bool nonConstantRightHandSide)
+  {
+    std::vector <bool> used;
+    const core::NumericalConstraints_t& ncs (cp->numericalConstraints ());
+    for (core::NumericalConstraints_t::const_iterator it = ncs.begin ();
+        it != ncs.end (); ++it) {
+      if (nonConstantRightHandSide && (*it)->constantRightHandSide ())
+        continue;
+      const constraints::ArrayXb& active
+        ((*it)->function ().activeParameters ());
+      used.resize (std::max (used.size (), (std::size_t) active.size ()),
+          false);
+      for (core::size_type i = 0; i < active.size (); ++i)
+        if (active[i]) used[i] = true;
+    }
+    const core::LockedJoints_t& ljs (cp->lockedJoints ());
+    for (core::LockedJoints_t::const_iterator it = ljs.begin ();
+        it != ljs.end (); ++it) {
+      if (nonConstantRightHandSide && (*it)->constantRightHandSide ())
+        continue;
+      std::size_t end = (std::size_t)
+        ((*it)->rankInConfiguration () + (*it)->configSize ());
+      used.resize (std::max (used.size (), end), false);
+      for (std::size_t i = (std::size_t) (*it)->rankInConfiguration ();
+          i < end; ++i)
+        used[i] = true;
+    }
+    std::vector <core::size_type> res;
+    for (std::size_t i = 0; i < used.size (); ++i)
+      if (used[i]) res.push_back ((core::size_type) i);
+    return res;
+  }
+
+  void reserveDeviceData (const DevicePtr_t& robot, std::size_t n)
+  {
+    if (robot->numberDeviceData () < (manipulation::size_type) n)
+      robot->numberDeviceData ((manipulation::size_type) n);
+  }
+
+  std::vector <Configuration_t> floatSeqSeqToConfigs
+  (const DevicePtr_t& robot, const floatSeqSeq& dofArrays)
+  {
+    std::vector <Configuration_t> qs (dofArrays.length ());
+    try {
+      for (CORBA::ULong i = 0; i < dofArrays.length (); ++i)
+        qs[i] = corbaServer::floatSeqToConfig (robot, dofArrays[i], true);
+    } catch (const std::exception& exc) {
+      throw Error (exc.what ());
+    }
+    return qs;
+  }
+
+  floatSeqSeq* configsToFloatSeqSeq (const std::vector <Configuration_t>& qs)
+  {
+    floatSeqSeq* ret = new floatSeqSeq ();
+    ret->length ((CORBA::ULong) qs.size ());
+    for (std::size_t i = 0; i < qs.size (); ++i) {
+      floatSeq& q = (*ret)[(CORBA::ULong) i];
+      q.length ((CORBA::ULong) qs[i].size ());
+      for (std::size_t j = 0; j < (std::size_t) qs[i].size (); ++j)
+        q[(CORBA::ULong) j] = qs[i][j];
+    }
+    return ret;
+  }
 } // namespace hpp
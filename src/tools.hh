@@ -18,12 +18,20 @@
 #ifndef HPP_MANIPULATION_CORBA_TOOLS_HH
 # define HPP_MANIPULATION_CORBA_TOOLS_HH
 
+# include <list>
+
+# include <boost/shared_ptr.hpp>
+# include <boost/weak_ptr.hpp>
+# include <boost/date_time/posix_time/posix_time_types.hpp>
+
 # include <pinocchio/spatial/se3.hpp>
 
 # include <hpp/corbaserver/conversions.hh>
 
 # include <hpp/manipulation/problem-solver.hh>
 
+# include "hpp/corbaserver/manipulation/gcommon.hh"
+
 namespace hpp {
   using corbaServer::floatSeqToVector;
   using corbaServer::vectorToFloatSeq;
@@ -33,6 +41,8 @@ namespace hpp {
   using pinocchio::Transform3f;
   using manipulation::DevicePtr_t;
   using manipulation::ProblemSolverPtr_t;
+  using manipulation::Configuration_t;
+  using manipulation::ConstraintSetPtr_t;
 
   inline std::vector<std::string> toStringVector (const Names_t& names) {
     typedef std::vector<std::string> Out_t;
@@ -55,6 +65,104 @@ namespace hpp {
   }
 
   DevicePtr_t getRobotOrThrow (ProblemSolverPtr_t p);
+
+  /// Measure the wall-clock time of an operation.
+  class Stopwatch
+  {
+    public:
+      Stopwatch () :
+        start_ (boost::posix_time::microsec_clock::universal_time ())
+      {}
+
+      /// Time since construction, in seconds.
+      manipulation::value_type elapsed () const
+      {
+        return 1e-6 * (manipulation::value_type) (
+            boost::posix_time::microsec_clock::universal_time ()
+            - start_).total_microseconds ();
+      }
+
+    private:
+      boost::posix_time::ptime start_;
+  }; // class Stopwatch
+
+  /// Data attached to objects owned by someone else, such as graphs or
+  /// roadmaps. The data of an object is dropped when the object is deleted.
+  ///
+  /// The objects are few, so they are kept in a list and searched linearly.
+  /// \note not thread safe: the owner of the map must protect it.
+  template <typename Key, typename Data> class WeakPtrMap
+  {
+    public:
+      typedef boost::shared_ptr <Key> KeyPtr_t;
+
+      /// Get the data of key, and create it if there is none.
+      /// The data of the deleted objects is dropped.
+      Data& get (const KeyPtr_t& key)
+      {
+        Data* data = find (key);
+        if (data) return *data;
+        entries_.push_back (std::make_pair (boost::weak_ptr <Key> (key),
+              Data ()));
+        return entries_.back ().second;
+      }
+
+      /// Get the data of key, or NULL if there is none.
+      /// The data of the deleted objects is dropped.
+      Data* find (const KeyPtr_t& key)
+      {
+        Data* found = NULL;
+        for (typename Entries_t::iterator it = entries_.begin ();
+            it != entries_.end ();) {
+          KeyPtr_t k (it->first.lock ());
+          if (!k) {
+            it = entries_.erase (it);
+            continue;
+          }
+          if (k == key) found = &it->second;
+          ++it;
+        }
+        return found;
+      }
+
+      void clear ()
+      {
+        entries_.clear ();
+      }
+
+    private:
+      typedef std::list <std::pair <boost::weak_ptr <Key>, Data> > Entries_t;
+      Entries_t entries_;
+  }; // class WeakPtrMap
+
+  /// Copy a constraint set so that it can be used by another thread.
+  ConstraintSetPtr_t copyConstraintSet (const ConstraintSetPtr_t& c);
+
+  /// Configuration coordinates the constraints of a projector depend on.
+  /// \param nonConstantRightHandSide if true, only the constraints with
+  ///        non constant right hand side are considered.
+  std::vector <core::size_type> constrainedCoordinates
+  (const core::ConfigProjectorPtr_t& cp, bool nonConstantRightHandSide);
+
+  /// Allow n threads to use the robot kinematic data simultaneously.
+  void reserveDeviceData (const DevicePtr_t& robot, std::size_t n);
+
+  /// Convert a list of configurations.
+  /// \throw hpp::Error if one of them has not the robot configuration size.
+  std::vector <Configuration_t> floatSeqSeqToConfigs
+  (const DevicePtr_t& robot, const floatSeqSeq& dofArrays);
+
+  floatSeqSeq* configsToFloatSeqSeq (const std::vector <Configuration_t>& qs);
+
+  template <typename InputIt> inline Bools_t* toBools_t
+  (InputIt begin, InputIt end)
+  {
+    Bools_t* ret = new Bools_t ();
+    ret->length ((CORBA::ULong) std::distance (begin, end));
+    CORBA::ULong i = 0;
+    for (InputIt it = begin; it != end; ++it, ++i) (*ret)[i] = (bool) *it;
+    return ret;
+  }
 } // namespace hpp
 
 #endif // HPP_MANIPULATION_CORBA_TOOLS_HH
@@ -0,0 +1,156 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "warm-start.hh"
+
+#include <limits>
+
+#include <hpp/core/config-projector.hh>
+
+#include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      WarmStartStore::WarmStartStore () : enabled_ (false), size_ (8)
+      {}
+
+      void WarmStartStore::enable (bool enabled, std::size_t size)
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        enabled_ = enabled;
+        if (size != size_) graphs_.clear ();
+        size_ = size;
+      }
+
+      bool WarmStartStore::enabled ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return enabled_;
+      }
+
+      std::size_t WarmStartStore::size ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return size_;
+      }
+
+      bool WarmStartStore::seed (const graph::GraphPtr_t& graph,
+          std::size_t id, const core::ConfigProjectorPtr_t& cp,
+          Configuration_t& q, value_type& maxDistance)
+      {
+        if (!cp) return false;
+        boost::mutex::scoped_lock lock (mutex_);
+        if (!enabled_) return false;
+        Solutions& s (solutions (graph, id, cp, q.size ()));
+        if (s.inputs.empty ()) return false;
+
+        // Replacing the constrained coordinates by those of a solution
+        // would give that solution, whatever q. The seed keeps the other
+        // coordinates of q, so the nearest input is searched on them.
+        std::size_t best = 0;
+        value_type dBest = std::numeric_limits <value_type>::infinity ();
+        for (std::size_t j = 0; j < s.inputs.size (); ++j) {
+          if (s.inputs[j].size () != q.size ()) continue;
+          value_type d = 0;
+          for (std::size_t i = 0; i < s.free.size (); ++i) {
+            value_type e = s.inputs[j][s.free[i]] - q[s.free[i]];
+            d += e * e;
+          }
+          if (d < dBest) {
+            dBest = d;
+            best = j;
+          }
+        }
+        if (dBest == std::numeric_limits <value_type>::infinity ())
+          return false;
+        const vector_t& move (s.moves[best]);
+        maxDistance = move.norm () + (s.inputs[best] - q).norm ();
+        for (std::size_t i = 0; i < s.coordinates.size (); ++i)
+          q[s.coordinates[i]] += move[i];
+        return true;
+      }
+
+      void WarmStartStore::add (const graph::GraphPtr_t& graph,
+          std::size_t id, const core::ConfigProjectorPtr_t& cp,
+          const Configuration_t& input, const Configuration_t& q)
+      {
+        if (!cp) return;
+        boost::mutex::scoped_lock lock (mutex_);
+        if (!enabled_ || size_ == 0) return;
+        Solutions& s (solutions (graph, id, cp, input.size ()));
+        vector_t move (s.coordinates.size ());
+        for (std::size_t i = 0; i < s.coordinates.size (); ++i)
+          move[i] = q[s.coordinates[i]] - input[s.coordinates[i]];
+        if (s.inputs.size () < size_) {
+          s.inputs.push_back (input);
+          s.moves.push_back (move);
+        } else {
+          s.inputs[s.next] = input;
+          s.moves[s.next] = move;
+          s.next = (s.next + 1) % size_;
+        }
+      }
+
+      void WarmStartStore::clear ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        graphs_.clear ();
+      }
+
+      void WarmStartStore::copy (WarmStartStore& other,
+          const graph::GraphPtr_t& graph)
+      {
+        Components_t components;
+        bool enabled;
+        std::size_t size;
+        {
+          boost::mutex::scoped_lock lock (other.mutex_);
+          if (Components_t* c = other.graphs_.find (graph)) components = *c;
+          enabled = other.enabled_;
+          size = other.size_;
+        }
+        boost::mutex::scoped_lock lock (mutex_);
+        graphs_.clear ();
+        graphs_.get (graph).swap (components);
+        enabled_ = enabled;
+        size_ = size;
+      }
+
+      WarmStartStore::Solutions& WarmStartStore::solutions
+      (const graph::GraphPtr_t& graph, std::size_t id,
+       const core::ConfigProjectorPtr_t& cp, size_type nq)
+      {
+        Components_t& components (graphs_.get (graph));
+        std::pair <Components_t::iterator, bool> res =
+          components.insert (std::make_pair (id, Solutions ()));
+        Solutions& s (res.first->second);
+        if (res.second)
+          s.coordinates = constrainedCoordinates (cp, false);
+        if (s.free.empty () && s.coordinates.size () < (std::size_t) nq) {
+          std::vector <bool> constrained ((std::size_t) nq, false);
+          for (std::size_t i = 0; i < s.coordinates.size (); ++i)
+            if (s.coordinates[i] < nq)
+              constrained[(std::size_t) s.coordinates[i]] = true;
+          for (size_type i = 0; i < nq; ++i)
+            if (!constrained[(std::size_t) i]) s.free.push_back (i);
+        }
+        return s;
+      }
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,109 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_CORBA_WARM_START_HH
+# define HPP_MANIPULATION_CORBA_WARM_START_HH
+
+# include <map>
+# include <vector>
+
+# include <boost/thread/mutex.hpp>
+
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/graph/fwd.hh>
+
+# include "tools.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace impl {
+      /// Recent projections onto each graph component.
+      ///
+      /// The store keeps the input of each projection and how the
+      /// projection moved the coordinates the constraints depend on. A
+      /// configuration to project is seeded with the move of the projection
+      /// of the nearest input, so that the seed, and the solution, still
+      /// depend on the configuration. The other coordinates are left
+      /// unchanged. The nearest input is the one closest on these other
+      /// coordinates, which the seed keeps.
+      ///
+      /// The projections are kept per constraint graph, and those of a graph
+      /// are dropped when the graph is deleted.
+      class WarmStartStore
+      {
+        public:
+          WarmStartStore ();
+
+          /// \param size number of solutions kept per component.
+          void enable (bool enabled, std::size_t size);
+          bool enabled ();
+          std::size_t size ();
+
+          /// Move the constrained coordinates of q as the projection of the
+          /// nearest input moved them.
+          /// \param maxDistance set to the distance from q beyond which a
+          ///        solution found from the seed is not a projection of q:
+          ///        the length of the move plus the distance between q and
+          ///        the nearest input.
+          /// \return whether q was modified.
+          bool seed (const graph::GraphPtr_t& graph, std::size_t id,
+              const core::ConfigProjectorPtr_t& cp, Configuration_t& q,
+              value_type& maxDistance);
+
+          /// Store a projection onto component id.
+          /// \param input the configuration before projection,
+          /// \param q its projection.
+          void add (const graph::GraphPtr_t& graph, std::size_t id,
+              const core::ConfigProjectorPtr_t& cp,
+              const Configuration_t& input, const Configuration_t& q);
+
+          void clear ();
+
+          /// Copy the state of another store and its solutions for graph.
+          /// The projections of a batch are seeded from such a copy, so
+          /// that they do not depend on the order in which they are done.
+          void copy (WarmStartStore& other, const graph::GraphPtr_t& graph);
+
+        private:
+          struct Solutions {
+            Solutions () : next (0) {}
+            /// Coordinates the constraints depend on, and the others.
+            std::vector <size_type> coordinates, free;
+            /// Ring buffers of the inputs of the projections, and of the
+            /// moves of their constrained coordinates.
+            std::vector <Configuration_t> inputs;
+            std::vector <vector_t> moves;
+            std::size_t next;
+          };
+          typedef std::map <std::size_t, Solutions> Components_t;
+
+          /// \param nq size of the configurations.
+          /// \note mutex_ must be locked.
+          Solutions& solutions (const graph::GraphPtr_t& graph,
+              std::size_t id, const core::ConfigProjectorPtr_t& cp,
+              size_type nq);
+
+          WeakPtrMap <graph::Graph, Components_t> graphs_;
+          bool enabled_;
+          std::size_t size_;
+          boost::mutex mutex_;
+      }; // class WarmStartStore
+    } // namespace impl
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_CORBA_WARM_START_HH
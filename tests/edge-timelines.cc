@@ -0,0 +1,61 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE EdgeTimelines
+#include <boost/test/unit_test.hpp>
+
+#include "edge-timelines.hh"
+
+using hpp::manipulation::impl::EdgeTimelines;
+
+BOOST_AUTO_TEST_CASE (rank)
+{
+  EdgeTimelines::Timeline t;
+  BOOST_CHECK_EQUAL (t.rank (0.5), (std::size_t) 0);
+
+  // Three sub-paths: [0, 1], [1, 2.5] and [2.5, 3].
+  t.bounds.push_back (0);
+  t.bounds.push_back (1);
+  t.bounds.push_back (2.5);
+  t.bounds.push_back (3);
+  t.edges.push_back (4);
+  t.edges.push_back (-1);
+  t.edges.push_back (7);
+
+  BOOST_CHECK_EQUAL (t.rank (0), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (t.rank (0.5), (std::size_t) 0);
+  // A parameter at the boundary of two sub-paths belongs to the first one.
+  BOOST_CHECK_EQUAL (t.rank (1), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (t.rank (1.5), (std::size_t) 1);
+  BOOST_CHECK_EQUAL (t.rank (2.5), (std::size_t) 1);
+  BOOST_CHECK_EQUAL (t.rank (2.7), (std::size_t) 2);
+  BOOST_CHECK_EQUAL (t.rank (3), (std::size_t) 2);
+  // Out of range parameters belong to the first and last sub-paths.
+  BOOST_CHECK_EQUAL (t.rank (-1), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (t.rank (4), (std::size_t) 2);
+}
+
+BOOST_AUTO_TEST_CASE (single_path)
+{
+  EdgeTimelines::Timeline t;
+  t.bounds.push_back (0);
+  t.bounds.push_back (2);
+  t.edges.push_back (1);
+  BOOST_CHECK_EQUAL (t.rank (0), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (t.rank (1), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (t.rank (2), (std::size_t) 0);
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE JobQueue
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "job-queue.hh"
+
+using hpp::manipulation::impl::JobQueue;
+
+namespace {
+  /// Job that blocks until it is released.
+  struct Gate
+  {
+    Gate () : open (false), started (0) {}
+
+    void release ()
+    {
+      boost::mutex::scoped_lock lock (mutex);
+      open = true;
+      condition.notify_all ();
+    }
+
+    void wait ()
+    {
+      boost::mutex::scoped_lock lock (mutex);
+      ++started;
+      condition.notify_all ();
+      while (!open) condition.wait (lock);
+    }
+
+    void waitStarted (int n)
+    {
+      boost::mutex::scoped_lock lock (mutex);
+      while (started < n) condition.wait (lock);
+    }
+
+    bool open;
+    int started;
+    boost::mutex mutex;
+    boost::condition_variable condition;
+  }; // struct Gate
+
+  struct Blocked
+  {
+    Blocked (Gate& gate, long value) : gate_ (gate), value_ (value) {}
+
+    void operator() (std::vector <long>& result) const
+    {
+      gate_.wait ();
+      result.push_back (value_);
+    }
+
+    Gate& gate_;
+    long value_;
+  }; // struct Blocked
+
+  void fail (std::vector <long>&)
+  {
+    throw std::runtime_error ("failure");
+  }
+
+  /// Wait until the job is finished.
+  JobQueue::State finish (JobQueue& queue, long id)
+  {
+    hpp::manipulation::value_type elapsed;
+    std::string error;
+    for (;;) {
+      JobQueue::State state = queue.state (id, elapsed, error);
+      if (state != JobQueue::Pending && state != JobQueue::Running)
+        return state;
+      boost::this_thread::sleep (boost::posix_time::milliseconds (1));
+    }
+  }
+} // namespace
+
+BOOST_AUTO_TEST_CASE (result)
+{
+  JobQueue queue (2);
+  Gate gate;
+  long id = queue.submit (Blocked (gate, 7));
+  gate.waitStarted (1);
+  hpp::manipulation::value_type elapsed;
+  std::string error;
+  BOOST_CHECK_EQUAL (queue.state (id, elapsed, error), JobQueue::Running);
+  BOOST_CHECK_THROW (queue.result (id), std::logic_error);
+  gate.release ();
+  BOOST_CHECK_EQUAL (finish (queue, id), JobQueue::Done);
+  std::vector <long> result = queue.result (id);
+  BOOST_REQUIRE_EQUAL (result.size (), (std::size_t) 1);
+  BOOST_CHECK_EQUAL (result[0], 7);
+  // The job is forgotten once its result is taken.
+  BOOST_CHECK_THROW (queue.state (id, elapsed, error),
+      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE (failure)
+{
+  JobQueue queue (1);
+  long id = queue.submit (fail);
+  BOOST_CHECK_EQUAL (finish (queue, id), JobQueue::Failed);
+  hpp::manipulation::value_type elapsed;
+  std::string error;
+  queue.state (id, elapsed, error);
+  BOOST_CHECK_EQUAL (error, "failure");
+  BOOST_CHECK_THROW (queue.result (id), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE (cancel)
+{
+  JobQueue queue (1);
+  Gate gate;
+  long running = queue.submit (Blocked (gate, 1));
+  long pending = queue.submit (Blocked (gate, 2));
+  gate.waitStarted (1);
+  BOOST_CHECK (queue.cancel (pending));
+  BOOST_CHECK (queue.cancel (running));
+  gate.release ();
+  BOOST_CHECK_EQUAL (finish (queue, pending), JobQueue::Cancelled);
+  BOOST_CHECK_EQUAL (finish (queue, running), JobQueue::Cancelled);
+  BOOST_CHECK (!queue.cancel (running));
+  BOOST_CHECK_THROW (queue.result (running), std::runtime_error);
+  // The pending job never ran.
+  BOOST_CHECK_EQUAL (gate.started, 1);
+}
+
+BOOST_AUTO_TEST_CASE (bounds)
+{
+  JobQueue queue (1, 2, 1);
+  Gate gate;
+  long first = queue.submit (Blocked (gate, 1));
+  long second = queue.submit (Blocked (gate, 2));
+  BOOST_CHECK_THROW (queue.submit (Blocked (gate, 3)), std::length_error);
+  gate.release ();
+  // The jobs run in turn on the single thread, and only the last finished
+  // one is kept.
+  BOOST_CHECK_EQUAL (finish (queue, second), JobQueue::Done);
+  hpp::manipulation::value_type elapsed;
+  std::string error;
+  BOOST_CHECK_THROW (queue.state (first, elapsed, error),
+      std::invalid_argument);
+  BOOST_CHECK_EQUAL (queue.state (second, elapsed, error), JobQueue::Done);
+}
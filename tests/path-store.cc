@@ -0,0 +1,105 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE PathStore
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include <hpp/core/path-vector.hh>
+
+#include "path-store.hh"
+
+using hpp::manipulation::impl::PathStore;
+using hpp::core::PathVector;
+using hpp::core::PathVectorPtr_t;
+
+namespace {
+  PathVectorPtr_t path ()
+  {
+    return PathVector::create (3, 3);
+  }
+} // namespace
+
+BOOST_AUTO_TEST_CASE (least_recently_used)
+{
+  PathStore store (3);
+  PathStore::Id_t a = store.add (path ()),
+                  b = store.add (path ()),
+                  c = store.add (path ());
+  BOOST_CHECK (a != b && b != c);
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 3);
+
+  // a becomes the most recently used, so b is evicted.
+  BOOST_CHECK (store.get (a));
+  PathStore::Id_t d = store.add (path ());
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 3);
+  BOOST_CHECK_EQUAL (store.evicted (), (std::size_t) 1);
+  BOOST_CHECK (store.get (a));
+  BOOST_CHECK (!store.get (b));
+  BOOST_CHECK (store.get (c));
+  BOOST_CHECK (store.get (d));
+
+  // The identifiers are never reused.
+  BOOST_CHECK (store.add (path ()) > d);
+}
+
+BOOST_AUTO_TEST_CASE (pinned)
+{
+  PathStore store (2);
+  PathStore::Id_t a = store.add (path ()),
+                  b = store.add (path ());
+  store.pin (a, true);
+  store.pin (b, true);
+  // The path just added is kept even though the others are pinned.
+  PathStore::Id_t c = store.add (path ());
+  BOOST_CHECK (store.get (a));
+  BOOST_CHECK (store.get (b));
+  BOOST_CHECK (store.get (c));
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 3);
+
+  // Unpinning lets the bound be satisfied again.
+  store.pin (a, false);
+  BOOST_CHECK (!store.get (a));
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 2);
+  BOOST_CHECK_THROW (store.pin (a, true), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE (bytes)
+{
+  std::size_t size = PathStore::bytes (path ());
+  BOOST_CHECK (size > 0);
+
+  PathStore store (0, 2 * size);
+  PathStore::Id_t a = store.add (path ());
+  store.add (path ());
+  BOOST_CHECK_EQUAL (store.bytes (), 2 * size);
+  store.add (path ());
+  BOOST_CHECK_EQUAL (store.bytes (), 2 * size);
+  BOOST_CHECK (!store.get (a));
+
+  // A path larger than the store is rejected, and nothing is evicted.
+  store.capacity (0, size - 1);
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 0);
+  BOOST_CHECK_THROW (store.add (path ()), std::invalid_argument);
+
+  store.capacity (0, 0);
+  store.add (path ());
+  store.clear ();
+  BOOST_CHECK_EQUAL (store.size (), (std::size_t) 0);
+  BOOST_CHECK_EQUAL (store.bytes (), (std::size_t) 0);
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE ProblemLocks
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <hpp/manipulation/problem-solver.hh>
+#include <hpp/corbaserver/server.hh>
+#include <hpp/corbaserver/manipulation/server.hh>
+
+#include "hpp/corbaserver/manipulation/gcommon.hh"
+#include "problem-locks.hh"
+
+using hpp::manipulation::ProblemSolver;
+using hpp::manipulation::ProblemSolverPtr_t;
+using hpp::manipulation::impl::ProblemLocks;
+
+namespace {
+  int argc = 1;
+  const char* argv[] = { "problem-locks" };
+
+  /// A server with the problems "default", selected, and "other".
+  /// It is created once, since the servers initialize CORBA.
+  struct Servers
+  {
+    Servers () :
+      selected (ProblemSolver::create ()), other (ProblemSolver::create ()),
+      corbaServer (selected, argc, argv, true),
+      server (argc, argv, true)
+    {
+      server.setProblemSolverMap (corbaServer.problemSolverMap ());
+      corbaServer.problemSolverMap ()->map_["other"] = other;
+    }
+
+    ProblemSolverPtr_t selected, other;
+    hpp::corbaServer::Server corbaServer;
+    hpp::manipulation::Server server;
+  }; // struct Servers
+
+  Servers& servers ()
+  {
+    static Servers s;
+    return s;
+  }
+
+  struct Fixture
+  {
+    Fixture () :
+      server (&servers ().server), selected (servers ().selected),
+      other (servers ().other)
+    {}
+
+    ProblemLocks& locks ()
+    {
+      return server->problemLocks ();
+    }
+
+    hpp::manipulation::Server* server;
+    ProblemSolverPtr_t selected, other;
+  }; // struct Fixture
+
+  void takeLock (hpp::manipulation::Server* server, ProblemLocks::Mode mode,
+      const char* problem, bool* done)
+  {
+    ProblemLocks::Lock lock (server, mode, problem);
+    *done = true;
+  }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE (problem_locks, Fixture)
+
+BOOST_AUTO_TEST_CASE (binding)
+{
+  BOOST_CHECK (locks ().bound () == NULL);
+  {
+    ProblemLocks::Lock lock (server, ProblemLocks::Read);
+    BOOST_REQUIRE (locks ().bound () != NULL);
+    BOOST_CHECK_EQUAL (locks ().bound ()->name, "default");
+    BOOST_CHECK (locks ().bound ()->problemSolver == selected);
+  }
+  BOOST_CHECK (locks ().bound () == NULL);
+  {
+    ProblemLocks::Lock lock (server, ProblemLocks::Write, "other");
+    BOOST_REQUIRE (locks ().bound () != NULL);
+    BOOST_CHECK (locks ().bound ()->problemSolver == other);
+  }
+  BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Read,
+        "missing"), hpp::Error);
+  BOOST_CHECK (locks ().bound () == NULL);
+}
+
+BOOST_AUTO_TEST_CASE (nesting)
+{
+  {
+    // Weaker or equal nested locks are granted without locking again.
+    ProblemLocks::Lock write (server, ProblemLocks::Write);
+    {
+      ProblemLocks::Lock read (server, ProblemLocks::Read);
+      ProblemLocks::Lock write2 (server, ProblemLocks::Write);
+    }
+    // The outer lock still binds the thread.
+    BOOST_REQUIRE (locks ().bound () != NULL);
+    BOOST_CHECK (locks ().bound ()->problemSolver == selected);
+  }
+  {
+    // Nested locks cannot be stronger.
+    ProblemLocks::Lock read (server, ProblemLocks::Read);
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Write),
+        hpp::Error);
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Select),
+        hpp::Error);
+  }
+  {
+    ProblemLocks::Lock write (server, ProblemLocks::Write);
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Exclusive),
+        hpp::Error);
+  }
+  {
+    ProblemLocks::Lock exclusive (server, ProblemLocks::Exclusive);
+    ProblemLocks::Lock write (server, ProblemLocks::Write);
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Select),
+        hpp::Error);
+  }
+  {
+    // Nested locks use the problem of the outer lock.
+    ProblemLocks::Lock read (server, ProblemLocks::Read, "other");
+    ProblemLocks::Lock nested (server, ProblemLocks::Read, "other");
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Read,
+          "default"), hpp::Error);
+  }
+  {
+    // The selection cannot be changed while changing it for a problem.
+    ProblemLocks::Lock select (server, ProblemLocks::Select);
+    ProblemLocks::Lock read (server, ProblemLocks::Read);
+    BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Read,
+          "other"), hpp::Error);
+  }
+  // Nor from a problem handle.
+  BOOST_CHECK_THROW (ProblemLocks::Lock (server, ProblemLocks::Select,
+        "other"), hpp::Error);
+}
+
+BOOST_AUTO_TEST_CASE (bind)
+{
+  {
+    ProblemLocks::Bind bind (server, "other");
+    ProblemLocks::Lock lock (server, ProblemLocks::Read);
+    BOOST_CHECK (locks ().bound ()->problemSolver == other);
+    BOOST_CHECK_THROW (ProblemLocks::Bind (server, "default"),
+        std::logic_error);
+  }
+  BOOST_CHECK (locks ().bound () == NULL);
+}
+
+BOOST_AUTO_TEST_CASE (exclusive)
+{
+  bool done = false;
+  boost::thread thread;
+  {
+    // An Exclusive lock waits for the requests on other problems.
+    ProblemLocks::Lock read (server, ProblemLocks::Read, "other");
+    thread = boost::thread (boost::bind (takeLock, server,
+          ProblemLocks::Exclusive, "", &done));
+    boost::this_thread::sleep (boost::posix_time::milliseconds (50));
+    BOOST_CHECK (!done);
+  }
+  thread.join ();
+  BOOST_CHECK (done);
+}
+
+BOOST_AUTO_TEST_CASE (share_and_erase)
+{
+  {
+    ProblemLocks::Lock select (server, ProblemLocks::Select);
+    locks ().share ("other", "default");
+  }
+  bool done = false;
+  boost::thread thread;
+  {
+    // The requests on both problems are serialized.
+    ProblemLocks::Lock write (server, ProblemLocks::Write);
+    thread = boost::thread (boost::bind (takeLock, server,
+          ProblemLocks::Write, "other", &done));
+    boost::this_thread::sleep (boost::posix_time::milliseconds (50));
+    BOOST_CHECK (!done);
+  }
+  thread.join ();
+  BOOST_CHECK (done);
+
+  // Once erased, "other" gets a lock of its own.
+  {
+    ProblemLocks::Lock select (server, ProblemLocks::Select);
+    locks ().erase ("other");
+  }
+  done = false;
+  {
+    ProblemLocks::Lock write (server, ProblemLocks::Write);
+    thread = boost::thread (boost::bind (takeLock, server,
+          ProblemLocks::Write, "other", &done));
+    thread.join ();
+    BOOST_CHECK (done);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END ()
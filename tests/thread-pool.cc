@@ -0,0 +1,133 @@
+// Copyright (c) 2018 CNRS
+// Author: Joseph Mirabel
+//
+// This file is part of hpp-manipulation-corba.
+// hpp-manipulation-corba is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation-corba is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation-corba.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE ThreadPool
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "thread-pool.hh"
+
+using hpp::manipulation::impl::ThreadPool;
+
+namespace {
+  /// Count the calls per item and check that a worker never runs two
+  /// tasks at once.
+  struct Count
+  {
+    Count (std::size_t n, std::size_t nbWorkers) :
+      calls (n, 0), busy (nbWorkers, false), overlap (false),
+      badWorker (false)
+    {}
+
+    void operator() (std::size_t i, std::size_t worker)
+    {
+      {
+        boost::mutex::scoped_lock lock (mutex);
+        ++calls[i];
+        if (worker >= busy.size ()) {
+          badWorker = true;
+          return;
+        }
+        if (busy[worker]) overlap = true;
+        busy[worker] = true;
+      }
+      boost::this_thread::yield ();
+      boost::mutex::scoped_lock lock (mutex);
+      busy[worker] = false;
+    }
+
+    std::vector <int> calls;
+    std::vector <bool> busy;
+    bool overlap, badWorker;
+    boost::mutex mutex;
+  }; // struct Count
+
+  struct Throw
+  {
+    Throw (std::vector <int>& calls) : calls_ (calls) {}
+
+    void operator() (std::size_t i, std::size_t) const
+    {
+      calls_[i] = 1;
+      if (i == 3) throw std::invalid_argument ("item 3");
+    }
+
+    std::vector <int>& calls_;
+  }; // struct Throw
+
+  struct Custom
+  {
+    int value;
+  }; // struct Custom
+
+  void throwCustom (std::size_t i, std::size_t)
+  {
+    if (i == 0) {
+      Custom c;
+      c.value = 42;
+      throw c;
+    }
+  }
+} // namespace
+
+BOOST_AUTO_TEST_CASE (every_item_once)
+{
+  ThreadPool pool (4);
+  BOOST_CHECK_EQUAL (pool.size (), (std::size_t) 4);
+  for (std::size_t n = 0; n < 200; n += 37) {
+    Count count (n, pool.size ());
+    pool.parallelFor (n, boost::ref (count));
+    for (std::size_t i = 0; i < n; ++i)
+      BOOST_CHECK_EQUAL (count.calls[i], 1);
+    BOOST_CHECK (!count.overlap);
+    BOOST_CHECK (!count.badWorker);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (default_size)
+{
+  ThreadPool pool;
+  BOOST_CHECK (pool.size () > 0);
+}
+
+BOOST_AUTO_TEST_CASE (first_exception_unchanged)
+{
+  ThreadPool pool (3);
+  std::vector <int> calls (50, 0);
+  BOOST_CHECK_THROW (pool.parallelFor (calls.size (), Throw (calls)),
+      std::invalid_argument);
+  // The other items are processed anyway.
+  for (std::size_t i = 0; i < calls.size (); ++i)
+    BOOST_CHECK_EQUAL (calls[i], 1);
+
+  try {
+    pool.parallelFor (10, throwCustom);
+    BOOST_ERROR ("parallelFor should have thrown.");
+  } catch (const Custom& c) {
+    BOOST_CHECK_EQUAL (c.value, 42);
+  }
+
+  // The pool is still usable.
+  Count count (10, pool.size ());
+  pool.parallelFor (10, boost::ref (count));
+  for (std::size_t i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL (count.calls[i], 1);
+}